@@ -33,10 +33,20 @@
 #include "rb2.h"
 #include "usart.h"
 
+// Value of the request word when the application asked for the bootloader.
+#define BOOT_REQUEST_MAGIC      0xB007
+
+// The request word survives the watchdog reset used to enter the
+// bootloader so a requested entry can be told from a watchdog reset
+// caused by a hung application.
+static uint16_t boot_request __attribute__ ((section (".noinit")));
+
 int
 main (void)
 {
     uint8_t mcucsr;
+    uint8_t requested;
+    uint8_t hung;
 
     // Set up function pointer to RESET vector.
     void (*reset_vector)( void ) = 0x0000;
@@ -44,15 +54,22 @@ main (void)
     // Clear interrupts.
     cli();
 
-    // Read and clear the MCU status register.  The MCUSR is used
-    // to determine the reason for activation of the bootloader.
+    // Read the MCU status register.  The MCUSR is used to determine
+    // the reason for activation of the bootloader.
     mcucsr = MCUCSR;
-    MCUCSR = 0;
+
+    // Was the bootloader requested before the reset?
+    requested = (boot_request == BOOT_REQUEST_MAGIC) ? 1 : 0;
+    boot_request = 0;
 
     // Reset the MCU if we got to this code for a reason other than a reset.
-    // We do this to make sure the MCU is a sane state.
+    // We do this to make sure the MCU is a sane state.  The application
+    // jumps here to request the bootloader so remember the request.
     if ((mcucsr & ((1<<JTRF) | (1<<WDRF) | (1<<BORF) | (1<<EXTRF) | (1<<PORF))) == 0)
     {
+        // Remember the request across the reset.
+        boot_request = BOOT_REQUEST_MAGIC;
+
         // Enable the watchdog with minimum pre-scaling.
         WDTCR = (0<<WDCE) | (1<<WDE) | (0<<WDP2) | (0<<WDP1) | (0<<WDP0);
 
@@ -66,10 +83,18 @@ main (void)
     DDRB &= ~(1<<DDB2);
     PORTB |= (1<<PB1);
 
-    // We activate the bootloader if the PB1 pin is held low or
-    // if we are here for a reset other than a power on reset.
+    // A watchdog reset that was not requested means the application hung.
+    hung = ((mcucsr & (1<<WDRF)) && !requested) ? 1 : 0;
+
+    // Clear the MCU status register unless the application hung.  The
+    // application then reads the watchdog flag itself.
+    if (!hung) MCUCSR = 0;
+
+    // We activate the bootloader if the PB1 pin is held low or if we
+    // are here for a reset other than a power on reset or a hang of the
+    // application.
     // if ((mcucsr & (1<<PORF)) != (1<<PORF))
-    if (((PINB & (1<<PINB1)) == 0) || ((mcucsr & (1<<PORF)) != (1<<PORF)))
+    if (((PINB & (1<<PINB1)) == 0) || (((mcucsr & (1<<PORF)) != (1<<PORF)) && !hung))
     {
         // Initialize programming module.
         prog_init();
@@ -39,4 +39,8 @@
 // Define the timer queue tick rate in Hz.
 #define TICKRATE 1000
 
+// Define the IMU update period in milliseconds.  This should be no longer
+// than the control period of the robot reading the IMU.
+#define IMU_PERIOD 5
+
 #endif // _CONFIG_H_
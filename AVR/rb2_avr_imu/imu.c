@@ -130,13 +130,13 @@ NAKEDFUNC(imu_task)
     AvrXSetSemaphore(&imu_mutex);
 
     // Initialize the tilt module.
-    tilt_init(&pitch_tilt_state, 0.02, 0.3, 0.003, 0.001);
+    tilt_init(&pitch_tilt_state, IMU_PERIOD / 1000.0, 0.3, 0.003, 0.001);
 
     // Loop processing IMU data.
     for (;;)
     {
-        // Start the 20 millisecond timer.
-        AvrXStartTimer(&imu_timer, 20);
+        // Start the IMU period timer.
+        AvrXStartTimer(&imu_timer, IMU_PERIOD);
 
         // Grab the latest ADC samples.
         adc_get_values(&meas_gyro_x, &meas_accel_y, &meas_accel_z);
@@ -195,7 +195,7 @@ NAKEDFUNC(imu_task)
         // Release exclusive access to the IMU values.
         AvrXSetSemaphore(&imu_mutex);
 
-        // Wait for the remainder of the 20 milliseconds to elapse.
+        // Wait for the remainder of the IMU period to elapse.
         AvrXWaitTimer(&imu_timer);
     }
 }
@@ -297,6 +297,42 @@ NAKEDFUNC(rb2_task)
                     // Send the low byte of the z acceleration.
                     rb2_xmit_data(result & 0xff);
                 }
+                else if (data == 0x0b)
+                {
+                    // Latch the current IMU values and send the pitch angle and rate
+                    // as a burst of four bytes.  This replaces the latch and four
+                    // separate byte requests in the time critical balance loop.
+                    imu_latch();
+
+                    // Send the pitch angle.
+                    result = imu_get_pitch_angle();
+                    rb2_xmit_data(result >> 8);
+                    rb2_xmit_data(result & 0xff);
+
+                    // Send the pitch rate.
+                    result = imu_get_pitch_rate();
+                    rb2_xmit_data(result >> 8);
+                    rb2_xmit_data(result & 0xff);
+                }
+                else if (data == 0x0c)
+                {
+                    // Send the latched raw values as a burst of six bytes.
+
+                    // Send the x gyro.
+                    result = imu_get_gyro_x();
+                    rb2_xmit_data(result >> 8);
+                    rb2_xmit_data(result & 0xff);
+
+                    // Send the y acceleration.
+                    result = imu_get_accel_y();
+                    rb2_xmit_data(result >> 8);
+                    rb2_xmit_data(result & 0xff);
+
+                    // Send the z acceleration.
+                    result = imu_get_accel_z();
+                    rb2_xmit_data(result >> 8);
+                    rb2_xmit_data(result & 0xff);
+                }
                 else if (data == 0xff)
                 {
                     // We are being deselected.
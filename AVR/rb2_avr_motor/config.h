@@ -39,4 +39,18 @@
 // Define the timer queue tick rate in Hz.
 #define TICKRATE 1000
 
+// Define the motor velocity loop period in milliseconds.  The velocity
+// units and gains remain per 10 milliseconds at any period.
+#define MOTOR_PERIOD 10
+// #define MOTOR_PERIOD 5
+
+// Define the time in milliseconds after which the motors are disabled
+// if a bus master stops sending velocity setpoints.
+#define MOTOR_TIMEOUT 100
+
+// Define as 1 when the wheel encoders are wired to this module and
+// decoded here rather than read from a Shaft2-D module on the bus.
+#define ENCODER_QUADRATURE 0
+// #define ENCODER_QUADRATURE 1
+
 #endif // _CONFIG_H_
@@ -30,7 +30,9 @@
 #include <stdint.h>
 #include <avr/io.h>
 #include "avrx.h"
+#include "config.h"
 #include "encoder.h"
+#include "quadrature.h"
 #include "usart.h"
 
 // Task control.
@@ -64,6 +66,10 @@ void encoder_init(void)
     // Release exclusive access to the encoder values.
     AvrXSetSemaphore(&encoder_mutex);
 
+#if ENCODER_QUADRATURE
+    // Start decoding the encoders.
+    quadrature_init();
+#else
     // Grab access to the USART.
     usart_grab_access();
 
@@ -85,6 +91,7 @@ void encoder_init(void)
 
     // Release access to the USART.
     usart_release_access();
+#endif
 }
 
 
@@ -94,6 +101,10 @@ void encoder_update(void)
     int16_t left_encoder = 0;
     int16_t right_encoder = 0;
 
+#if ENCODER_QUADRATURE
+    // Get the counts decoded from the encoders.
+    quadrature_get_counts(&left_encoder, &right_encoder);
+#else
     // Grab access to the USART.
     usart_grab_access();
 
@@ -151,6 +162,7 @@ void encoder_update(void)
 
     // Release access to the USART.
     usart_release_access();
+#endif
 
     // We invert the position of the left motor to account for the
     // fact that the wheels are geomtrically opposed to each other
@@ -27,12 +27,27 @@
 #include <stdint.h>
 #include <avr/io.h>
 #include "avrx.h"
+#include "config.h"
 #include "encoder.h"
 #include "motor.h"
+#include "pid2.h"
 #include "usart.h"
 
+// The motor velocity is commanded in encoder units per 10 milliseconds so
+// the encoder deltas are scaled up when the loop period is shorter.
+#define MOTOR_DELTA_SCALE       (10 / MOTOR_PERIOD)
+
+// The integral is accumulated every loop so its limit is scaled to keep
+// the same range of contribution as a 10 millisecond loop.
+#define MOTOR_MAX_ERROR_I       (255 * MOTOR_DELTA_SCALE)
+
+// Number of loops without a velocity setpoint before the motors are disabled.
+#define MOTOR_TIMEOUT_LOOPS     (MOTOR_TIMEOUT / MOTOR_PERIOD)
+
 // Note: Assuming globals are zeroed.
 uint8_t motor_enabled;
+uint8_t motor_remote;
+uint8_t motor_remote_age;
 int16_t motor_left_cmd;
 int16_t motor_left_p_gain;
 int16_t motor_left_d_gain;
@@ -46,6 +61,9 @@ int16_t motor_right_i_gain;
 int16_t motor_right_max_error_i;
 int8_t motor_right_pwm;
 
+// Velocity loop state for both wheels.
+static pid2 motor_pid;
+
 // Task control.
 AVRX_TIMER(motor_timer);
 AVRX_MUTEX(motor_mutex);
@@ -98,6 +116,28 @@ void motor_command_get(int16_t *left_cmd, int16_t *right_cmd)
 }
 
 
+void motor_remote_set(uint8_t enable, int16_t left_cmd, int16_t right_cmd)
+// Set the enabled flag and the left/right motor command velocity values
+// on behalf of a bus master.  The motors are disabled if the master does
+// not send new values within the timeout.
+{
+    // Get exclusive access to the motor variables.
+    AvrXWaitSemaphore(&motor_mutex);
+
+    // Set the enabled flag and left/right motor command value.
+    motor_enabled = enable;
+    motor_left_cmd = left_cmd;
+    motor_right_cmd = right_cmd;
+
+    // Restart the timeout.
+    motor_remote = 1;
+    motor_remote_age = 0;
+
+    // Release exclusive access to the motor variables.
+    AvrXSetSemaphore(&motor_mutex);
+}
+
+
 void motor_left_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain)
 // Set the left motor gain values.  These are 8:8 fixed point values.
 {
@@ -232,97 +272,57 @@ static void motor_pwm_set(int8_t left_pwm, int8_t right_pwm)
 }
 
 
-static int8_t motor_left_calc_pwm(int16_t motor_vel)
+static void motor_calc_pwm(int16_t left_vel, int16_t right_vel, int8_t *left_pwm, int8_t *right_pwm)
+// Determine the left and right pwm values from the wheel velocities
+// scaled to encoder units per 10 milliseconds.
 {
-    int16_t error;
-    int16_t error_d;
-    int32_t pwm_output;
-    static int16_t error_i;
-    static int16_t prev_error;
-
-    // Determine velocity error.
-    error = motor_left_cmd - motor_vel;
-
-    // Determine velocity error derivative.
-    error_d = prev_error - error;
-
-    // Save the current velocity error.
-    prev_error = error;
-
-    // Multiply error and error derivative by 8:8 fixed gains to determine PWM output.
-    pwm_output = (int32_t) error * (int32_t) motor_left_p_gain;
-    pwm_output -= (int32_t) error_d * (int32_t) motor_left_d_gain;
-    pwm_output += (int32_t) error_i * (int32_t) motor_left_i_gain;
-
-    // Shift to account for fixed point gain.
-    pwm_output >>= 8;
+    int16_t error[PID2_CHANNELS];
+    int16_t error_d[PID2_CHANNELS];
+    int16_t pwm[PID2_CHANNELS];
+    static int16_t prev_error[PID2_CHANNELS];
 
-    // Range check the PWM output.
-    if (pwm_output > 127) pwm_output = 127;
-    if (pwm_output < -127) pwm_output = -127;
-
-    // Decay the integral error.
-    if (error_i > 0) error_i -= 1;
-    if (error_i < 0) error_i += 1;
-
-    // Add the error to the error integral.
-    error_i += error;
-
-    // Range check the error integral.
-    if (error_i > 255) error_i = 255;
-    if (error_i < -255) error_i = -255;
-
-    return (int8_t) pwm_output;
-}
+    // Get exclusive access to the motor variables.
+    AvrXWaitSemaphore(&motor_mutex);
 
+    // Load the gains.  The integral accumulates every loop so the integral
+    // gain is scaled to keep the contribution of a 10 millisecond loop.
+    pid2_set_p_gain(&motor_pid, PID2_LEFT, motor_left_p_gain);
+    pid2_set_d_gain(&motor_pid, PID2_LEFT, motor_left_d_gain);
+    pid2_set_i_gain(&motor_pid, PID2_LEFT, motor_left_i_gain / MOTOR_DELTA_SCALE);
+    pid2_set_p_gain(&motor_pid, PID2_RIGHT, motor_right_p_gain);
+    pid2_set_d_gain(&motor_pid, PID2_RIGHT, motor_right_d_gain);
+    pid2_set_i_gain(&motor_pid, PID2_RIGHT, motor_right_i_gain / MOTOR_DELTA_SCALE);
 
-static int8_t motor_right_calc_pwm(int16_t motor_vel)
-{
-    int16_t error;
-    int16_t error_d;
-    int32_t pwm_output;
-    static int16_t error_i;
-    static int16_t prev_error;
+    // Determine left/right velocity error.
+    error[PID2_LEFT] = motor_left_cmd - left_vel;
+    error[PID2_RIGHT] = motor_right_cmd - right_vel;
 
-    // Determine velocity error.
-    error = motor_right_cmd - motor_vel;
+    // Release exclusive access to the motor variables.
+    AvrXSetSemaphore(&motor_mutex);
 
-    // Determine velocity error derivative.
-    error_d = prev_error - error;
+    // Determine left/right velocity error derivative scaled to 10 milliseconds.
+    error_d[PID2_LEFT] = (prev_error[PID2_LEFT] - error[PID2_LEFT]) * MOTOR_DELTA_SCALE;
+    error_d[PID2_RIGHT] = (prev_error[PID2_RIGHT] - error[PID2_RIGHT]) * MOTOR_DELTA_SCALE;
 
     // Save the current velocity error.
-    prev_error = error;
-
-    // Multiply error and error derivative by 8:8 fixed gains to determine PWM output.
-    pwm_output = (int32_t) error * (int32_t) motor_right_p_gain;
-    pwm_output -= (int32_t) error_d * (int32_t) motor_right_d_gain;
-    pwm_output += (int32_t) error_i * (int32_t) motor_right_i_gain;
+    prev_error[PID2_LEFT] = error[PID2_LEFT];
+    prev_error[PID2_RIGHT] = error[PID2_RIGHT];
 
-    // Shift to account for fixed point gain.
-    pwm_output >>= 8;
+    // Process both errors through the dual channel pid algorithm.
+    pid2_get_outputs(&motor_pid, error, error_d, pwm);
 
-    // Range check the PWM output.
-    if (pwm_output > 127) pwm_output = 127;
-    if (pwm_output < -127) pwm_output = -127;
-
-    // Decay the integral error.
-    if (error_i > 0) error_i -= 1;
-    if (error_i < 0) error_i += 1;
-
-    // Add the error to the error integral.
-    error_i += error;
-
-    // Range check the error integral.
-    if (error_i > 255) error_i = 255;
-    if (error_i < -255) error_i = -255;
-
-    return (int8_t) pwm_output;
+    *left_pwm = (int8_t) pwm[PID2_LEFT];
+    *right_pwm = (int8_t) pwm[PID2_RIGHT];
 }
 
 
 NAKEDFUNC(motor_task)
 // Motor control task.
 {
+    // Static as the naked task has no stack frame for addressed locals.
+    static int8_t left_pwm;
+    static int8_t right_pwm;
+
     // Initialize the gains.
     motor_left_p_gain = 0x0780;
     motor_left_d_gain = 0x0066;
@@ -334,34 +334,48 @@ NAKEDFUNC(motor_task)
     // Prime the motor mutex.
     AvrXSetSemaphore(&motor_mutex);
 
+    // Initialize the velocity loop limits.
+    pid2_init(&motor_pid);
+    pid2_set_max_output(&motor_pid, 127);
+    pid2_set_max_integral(&motor_pid, MOTOR_MAX_ERROR_I);
+
     // Initialize the encoder module.
     encoder_init();
 
     // Main control loop.
     for (;;)
     {
-        register int8_t left_pwm = 0;
-        register int8_t right_pwm = 0;
-
-        // Start the 10 millisecond timer.
-        AvrXStartTimer(&motor_timer, 10);
+        // Start the loop period timer.
+        AvrXStartTimer(&motor_timer, MOTOR_PERIOD);
 
         // Update the motor encoder values.
         encoder_update();
 
+        // Disable the motors if the bus master stopped sending setpoints.
+        if (motor_remote && (++motor_remote_age > MOTOR_TIMEOUT_LOOPS))
+        {
+            motor_enabled = 0;
+            motor_remote = 0;
+        }
+
+        // By default the pwm values are zeroed.
+        left_pwm = 0;
+        right_pwm = 0;
+
         // Is PWM enabled to the motors?
         if (motor_enabled)
         {
             // Get the left and right pwm values using the delta between encoder
-            // updates as the velocity over the last 10 milliseconds.
-            left_pwm = motor_left_calc_pwm(encoder_get_left_delta());
-            right_pwm = motor_right_calc_pwm(encoder_get_right_delta());
+            // updates scaled to the velocity over 10 milliseconds.
+            motor_calc_pwm(encoder_get_left_delta() * MOTOR_DELTA_SCALE,
+                           encoder_get_right_delta() * MOTOR_DELTA_SCALE,
+                           &left_pwm, &right_pwm);
         }
 
     	// Update motors with new PWM values.
         motor_pwm_set(left_pwm, right_pwm);
 
-    	// Wait for the remainder of the 10 milliseconds to elapse.
+    	// Wait for the remainder of the loop period to elapse.
         AvrXWaitTimer(&motor_timer);
     }
 }
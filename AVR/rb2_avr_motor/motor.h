@@ -31,6 +31,7 @@ void motor_enable_set(uint8_t enable);
 uint8_t motor_enable_get(void);
 void motor_command_set(int16_t *left_cmd, int16_t *right_cmd);
 void motor_command_get(int16_t *left_cmd, int16_t *right_cmd);
+void motor_remote_set(uint8_t enable, int16_t left_cmd, int16_t right_cmd);
 void motor_left_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain);
 void motor_left_gains_get(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain);
 void motor_right_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain);
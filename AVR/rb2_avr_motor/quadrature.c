@@ -0,0 +1,122 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Quadrature decoding of the wheel encoders.  The left encoder A/B
+    channels are wired to PC0/PC1 and the right encoder A/B channels to
+    PC2/PC3, all within pin change interrupt group 1.  Each edge looks up
+    the count step from the previous and current channel states in a
+    table so both wheels are decoded with a single read of the port.
+    The counts are 16 bit and wrap as those of the Shaft2-D module do.
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "avrx.h"
+#include "quadrature.h"
+
+// Encoder channel pins on port C.
+#define QUADRATURE_MASK         ((1<<PC0) | (1<<PC1) | (1<<PC2) | (1<<PC3))
+
+// Count step indexed by the previous and current A/B states of a wheel.
+// Transitions that skip a state are lost edges and are not counted.
+static const int8_t quadrature_table[16] =
+{
+//   00  01  10  11     current
+     0, +1, -1,  0,  // previous 00
+    -1,  0,  0, +1,  // previous 01
+    +1,  0,  0, -1,  // previous 10
+     0, -1, +1,  0   // previous 11
+};
+
+// Note: Assuming globals are zeroed.
+static uint8_t quadrature_pins;
+static volatile int16_t quadrature_left_count;
+static volatile int16_t quadrature_right_count;
+
+void quadrature_init(void)
+// Initialize the quadrature decoding.
+{
+    // Enable the encoder channels as inputs with pull-ups.
+    DDRC &= ~QUADRATURE_MASK;
+    PORTC |= QUADRATURE_MASK;
+
+    // Save the starting channel states.
+    quadrature_pins = PINC & QUADRATURE_MASK;
+
+    // Enable the pin change interrupts for the encoder channels.
+    PCMSK1 = (1<<PCINT8) | (1<<PCINT9) | (1<<PCINT10) | (1<<PCINT11);
+    PCIFR = (1<<PCIF1);
+    PCICR |= (1<<PCIE1);
+}
+
+
+void quadrature_get_counts(int16_t *left_count, int16_t *right_count)
+// Get the left/right encoder counts.
+{
+    // Disable interrupts while the counts are read.
+    cli();
+
+    // Get the counts.
+    if (left_count) *left_count = quadrature_left_count;
+    if (right_count) *right_count = quadrature_right_count;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void quadrature_clear(void)
+// Clear the left/right encoder counts.
+{
+    // Disable interrupts while the counts are cleared.
+    cli();
+
+    // Clear the counts.
+    quadrature_left_count = 0;
+    quadrature_right_count = 0;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+SIGNAL(SIG_PIN_CHANGE1)
+// Handles the encoder channel pin change interrupt.  This does not call
+// into AvrX so it runs without switching to the kernel stack, keeping
+// the cost of each edge small at high wheel speeds.
+{
+    uint8_t pins;
+
+    // Read both wheels at once.
+    pins = PINC & QUADRATURE_MASK;
+
+    // Step the counts from the previous and current states of each wheel.
+    quadrature_left_count += quadrature_table[((quadrature_pins & 0x03) << 2) | (pins & 0x03)];
+    quadrature_right_count += quadrature_table[(quadrature_pins & 0x0c) | ((pins >> 2) & 0x03)];
+
+    // Save the states for the next edge.
+    quadrature_pins = pins;
+}
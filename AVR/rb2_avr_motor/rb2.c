@@ -33,6 +33,8 @@
 #include "avrx.h"
 #include "config.h"
 #include "bootloader.h"
+#include "motor.h"
+#include "quadrature.h"
 #include "rb2.h"
 #include "usart.h"
 
@@ -164,6 +166,135 @@ static void rb2_address_set(void)
 }
 
 
+static uint8_t rb2_recv_bytes(uint8_t *buffer, uint8_t count)
+// Receive the indicated number of data bytes.  Returns zero if
+// the transfer was interrupted by an address.
+{
+    uint8_t i;
+    uint16_t data;
+
+    for (i = 0; i < count; ++i)
+    {
+        // Wait for serial data.
+        data = rb2_recv_data();
+
+        // Stop on error.
+        if (data == (uint16_t) -1) return 0;
+
+        // Save the data byte.
+        buffer[i] = (uint8_t) data;
+    }
+
+    return 1;
+}
+
+
+static void rb2_motor_velocity_set(void)
+//  Handle the motor velocity set command.  The enable flag and the left
+//  and right velocity setpoints are received high byte first and the
+//  current left and right pwm values are sent as the response.
+{
+    int8_t left_pwm;
+    int8_t right_pwm;
+    uint8_t buffer[5];
+
+    // Receive the enable flag and setpoints.
+    if (rb2_recv_bytes(buffer, sizeof(buffer)))
+    {
+        // Update the motor control values.
+        motor_remote_set(buffer[0],
+                         (int16_t) (((uint16_t) buffer[1] << 8) | buffer[2]),
+                         (int16_t) (((uint16_t) buffer[3] << 8) | buffer[4]));
+
+        // Send the pwm values from the last loop as the response.
+        motor_pwm_get(&left_pwm, &right_pwm);
+        rb2_xmit_data((uint8_t) left_pwm);
+        rb2_xmit_data((uint8_t) right_pwm);
+    }
+}
+
+
+static void rb2_motor_gains_set(void)
+//  Handle the motor gains set command.  The left p, d and i gains
+//  followed by the right p, d and i gains are received high byte first.
+{
+    uint8_t i;
+    int16_t gains[6];
+    uint8_t buffer[12];
+
+    // Receive the gains.
+    if (rb2_recv_bytes(buffer, sizeof(buffer)))
+    {
+        // Assemble the gains.
+        for (i = 0; i < 6; ++i) gains[i] = (int16_t) (((uint16_t) buffer[i * 2] << 8) | buffer[i * 2 + 1]);
+
+        // Update the gains.
+        motor_left_gains_set(&gains[0], &gains[1], &gains[2]);
+        motor_right_gains_set(&gains[3], &gains[4], &gains[5]);
+
+        // Send the OK response.
+        rb2_xmit_data(0x00A5);
+    }
+}
+
+
+#if ENCODER_QUADRATURE
+static void rb2_encoder_read(void)
+//  Handle the encoder read command.  The left and right encoder counts
+//  are sent high byte first with the same sense as the Shaft2-D counts.
+{
+    int16_t left_count;
+    int16_t right_count;
+
+    // Latch both counts together.
+    quadrature_get_counts(&left_count, &right_count);
+
+    // Send the counts as the response.
+    rb2_xmit_data(((uint16_t) left_count >> 8) & 0xff);
+    rb2_xmit_data((uint16_t) left_count & 0xff);
+    rb2_xmit_data(((uint16_t) right_count >> 8) & 0xff);
+    rb2_xmit_data((uint16_t) right_count & 0xff);
+}
+
+
+static void rb2_motor_exchange(void)
+//  Handle the motor exchange command.  The encoder counts are latched
+//  as the command arrives, the enable flag and the left and right
+//  velocity setpoints are received high byte first, and the latched
+//  counts followed by the current pwm values are sent as the response.
+{
+    int8_t left_pwm;
+    int8_t right_pwm;
+    int16_t left_count;
+    int16_t right_count;
+    uint8_t buffer[5];
+
+    // Latch both counts together.
+    quadrature_get_counts(&left_count, &right_count);
+
+    // Receive the enable flag and setpoints.
+    if (rb2_recv_bytes(buffer, sizeof(buffer)))
+    {
+        // Update the motor control values.
+        motor_remote_set(buffer[0],
+                         (int16_t) (((uint16_t) buffer[1] << 8) | buffer[2]),
+                         (int16_t) (((uint16_t) buffer[3] << 8) | buffer[4]));
+
+        // Send the latched counts.
+        rb2_xmit_data(((uint16_t) left_count >> 8) & 0xff);
+        rb2_xmit_data((uint16_t) left_count & 0xff);
+        rb2_xmit_data(((uint16_t) right_count >> 8) & 0xff);
+        rb2_xmit_data((uint16_t) right_count & 0xff);
+
+        // Send the pwm values from the last loop.
+        motor_pwm_get(&left_pwm, &right_pwm);
+        rb2_xmit_data((uint8_t) left_pwm);
+        rb2_xmit_data((uint8_t) right_pwm);
+    }
+}
+#endif
+
+
 NAKEDFUNC(rb2_task)
 // Task to process the RoboBricks2 protocol.
 {
@@ -215,6 +346,29 @@ NAKEDFUNC(rb2_task)
                     // We are no longer selected.
                     rb2_selected = 0;
                 }
+                else if (data == 0x10)
+                {
+                    // We received MOTOR VELOCITY SET command.
+                    rb2_motor_velocity_set();
+                }
+                else if (data == 0x11)
+                {
+                    // We received MOTOR GAINS SET command.
+                    rb2_motor_gains_set();
+                }
+#if ENCODER_QUADRATURE
+                // The encoder commands need the encoders decoded here.
+                else if (data == 0x12)
+                {
+                    // We received ENCODER READ command.
+                    rb2_encoder_read();
+                }
+                else if (data == 0x13)
+                {
+                    // We received MOTOR EXCHANGE command.
+                    rb2_motor_exchange();
+                }
+#endif
                 else if (data == 0xff)
                 {
                     // We are being deselected.
@@ -217,6 +217,32 @@ static void rb2_reset_leds(void)
 }
 
 
+static void rb2_xmit_word(int16_t data)
+// Send a 16 bit word high byte first.
+{
+    rb2_xmit_data(((uint16_t) data >> 8) & 0xff);
+    rb2_xmit_data((uint16_t) data & 0xff);
+}
+
+
+static void rb2_frame_read(void)
+//  Handle the receiver frame read command.  The frame sequence, the frame
+//  time and the full 16 bit channels of a single frame are sent high byte
+//  first as the response.
+{
+    uint8_t i;
+    static receiver_frame frame;
+
+    // Get the current receiver frame.
+    receiver_frame_get(&frame);
+
+    // Send the frame sequence, time and channels.
+    rb2_xmit_data(frame.sequence);
+    rb2_xmit_word((int16_t) frame.time);
+    for (i = 0; i < RECEIVER_CHANNELS; ++i) rb2_xmit_word(frame.channels[i]);
+}
+
+
 NAKEDFUNC(rb2_task)
 // Task to process the RoboBricks2 protocol.
 {
@@ -320,6 +346,11 @@ NAKEDFUNC(rb2_task)
                     // Send the channel position.
                     rb2_xmit_data(result);
                 }
+                else if (data == 0x0c)
+                {
+                    // We received RECEIVER FRAME READ command.
+                    rb2_frame_read();
+                }
                 else if (data == 0xff)
                 {
                     // We are being deselected.
@@ -23,11 +23,17 @@
 
     $Id$
 
-    Vex receiver task.
+    Vex receiver decoding.  The input capture interrupt measures each
+    pulse of the receiver pulse train and collects the channels of a
+    frame at the full timer resolution.  A complete frame is published
+    with its sequence and time by swapping the two frame buffers so
+    readers always see a coherent set of channels.  The task only wakes
+    to clear the channels when the receiver signal is lost.
 */
 
 #include <stdio.h>
 #include <stdint.h>
+#include <string.h>
 #include <avr/pgmspace.h>
 #include <avr/io.h>
 #include <avr/interrupt.h>
@@ -42,33 +48,70 @@
 // Maximum duration of a non-sync pulse is 4000 uS (10000 clock ticks).
 #define MAX_DURATION            10000
 
+// Pulse duration of a centered channel in clock ticks.
+#define CENTER_DURATION         2650
+
+// Milliseconds without a pulse before the signal is considered lost.
+#define LOST_PERIOD             20
+
 // Note: Assuming globals are zeroed.
-uint8_t pulse_sync;
-uint8_t pulse_index;
-uint16_t pulse_start;
-uint16_t pulse_duration;
-int16_t pulse_norm;
-int8_t pulses[6];
+
+// Pulse train state only used by the interrupt.  The clock extends the
+// timer by adding the time between edges.
+static uint8_t pulse_index;
+static uint16_t pulse_start;
+static uint16_t pulse_edge;
+static uint32_t pulse_clock;
+
+// Double buffered frames.  The interrupt fills the back frame and swaps
+// it to the front once all channels are received.
+static receiver_frame frames[2];
+static volatile uint8_t frame_front;
+
+// Pulses seen by the interrupt to detect a lost signal.
+static volatile uint8_t pulse_count;
 
 // Task control.
-AVRX_MUTEX(receiver_mutex);
 AVRX_TIMER(receiver_timer);
 
+
 int8_t receiver_read(uint8_t channel)
-// Read the value from the specified channel.
+// Read the value from the specified channel scaled to fit within 8 bits.
+{
+    int16_t value;
+
+    // Disable interrupts so the frame is not swapped while read.
+    cli();
+
+    // Get the specified channel value from the current frame.
+    value = frames[frame_front].channels[channel % RECEIVER_CHANNELS];
+
+    // Enable interrupts.
+    sei();
+
+    return (int8_t) (value / 8);
+}
+
+
+void receiver_frame_get(receiver_frame *frame)
+// Copy the current frame.
 {
-    // Return the specified channel value.
-    return pulses[channel % 6];
+    // Disable interrupts so the frame is not swapped while copied.
+    cli();
+
+    // Copy the frame.
+    memcpy(frame, &frames[frame_front], sizeof(receiver_frame));
+
+    // Enable interrupts.
+    sei();
 }
 
+
 NAKEDFUNC(receiver_task)
 // Task for Vex receiver.
 {
-    pulses[0] = 1;
-    pulses[1] = 2;
-    pulses[2] = 3;
-    pulses[3] = 4;
-    pulses[4] = 5;
+    static uint8_t lost;
+    static uint8_t last_pulse_count;
 
     // Enable PB0/ICP1 as an input with a pull-up.
     DDRB &= ~(1<<DDB0);
@@ -100,83 +143,88 @@ NAKEDFUNC(receiver_task)
     // Set timer/counter1 control register C.
     TCCR1C = (0<<FOC1A) | (0<<FOC1B);                       // No force output compare for A or B.
 
+    // Wait for a sync pulse before collecting channels.
+    pulse_index = RECEIVER_CHANNELS;
+
     // Enable both input capture and output compare interrupts.
     TIMSK1 = (1<<ICIE1);                                    // Enable input capture interrupt.
 
-    // Initialize the pulse index.
-    pulse_index = 6;
-
     // Loop forever.
     for (;;)
     {
-        // Start the timer.
-        AvrXStartTimer(&receiver_timer, 20);
-
-        // Wait for timer or signal to wake up task.
-        AvrXWaitTimer(&receiver_timer);
+        // Wait for the lost signal period.
+        AvrXDelay(&receiver_timer, LOST_PERIOD);
 
-        // Determine if the timer expired or was signaled.
-        if (AvrXCancelTimer(&receiver_timer) != 0)
+        // Publish a single frame of centered channels once no pulse is seen.
+        if (pulse_count != last_pulse_count)
         {
-            // Was a sync received?
-            if (pulse_sync)
-            {
-                // Reset the pulse index.
-                pulse_index = 0;
-
-                // Reset the sync flag.
-                pulse_sync = 0;
-            }
-            else if (pulse_index < 6)
-            {
-                // Normalize the pulse fit within 8 bits of data.
-                pulse_norm = (int16_t) ((((int32_t) pulse_duration - 2650) * 128) / 1024);
-                if (pulse_norm > 127) pulse_norm = 127;
-                if (pulse_norm < -127) pulse_norm = -127;
-
-                // Update the indexed pulse duration.
-                pulses[pulse_index++] = (int8_t) pulse_norm;
-            }
+            lost = 0;
         }
-        else
+        else if (!lost)
         {
-            // Zero out the pulse table.
-            for (pulse_index = 0; pulse_index < 6; ++pulse_index) pulses[pulse_index] = 0;
+            cli();
+            memset(frames[0].channels, 0, sizeof(frames[0].channels));
+            memset(frames[1].channels, 0, sizeof(frames[1].channels));
+            frames[frame_front].sequence += 1;
+            pulse_index = RECEIVER_CHANNELS;
+            sei();
+            lost = 1;
         }
 
-        // Reset the timer semaphore after being canceled.
-        receiver_timer.semaphore = SEM_PEND;
+        last_pulse_count = pulse_count;
     }
 }
 
-// Global to quickly store ICR1 value.
-static uint16_t icr;
-
-INTERFACE void AvrXIntSetObjectSemaphore(pMutex);
 
-AVRX_SIGINT(SIG_INPUT_CAPTURE1)
-// Handles timer/counter1 capture interrupt.  We receive this 
-// either on the rising or falling edge of a pulse.
+ISR(SIG_INPUT_CAPTURE1)
+// Handles timer/counter1 capture interrupt.  We receive this either on
+// the rising or falling edge of a pulse.  This is a plain interrupt as it
+// never signals an AvrX task.
 {
-    // Switch to kernel stack.
-    IntProlog();
+    uint16_t icr;
+    int16_t pulse;
+    uint8_t back;
 
     // Capture the ICR.
     icr = ICR1;
 
+    // Advance the clock.
+    pulse_clock += (uint16_t) (icr - pulse_edge);
+    pulse_edge = icr;
+
     // Handle rising or falling edge of pulse.
     if (TCCR1B & (1<<ICES1))
     {
         // Rising edge of pulse.
 
-        // Determine the pulse duration.
-        pulse_duration = icr - pulse_start;
-
         // Wait for falling edge.
         TCCR1B &= ~(1<<ICES1);
 
-        // Set the sync flag if OCR1A indicates maximum duration exceeded.
-        if (TIFR1 & (1<<OCF1A)) pulse_sync = 1;
+        // A pulse longer than the maximum duration is the sync pulse which
+        // starts a new frame.
+        if (TIFR1 & (1<<OCF1A))
+        {
+            pulse_index = 0;
+        }
+        else if (pulse_index < RECEIVER_CHANNELS)
+        {
+            // Limit the pulse duration from center to the channel range.
+            pulse = (int16_t) (icr - pulse_start - CENTER_DURATION);
+            if (pulse > RECEIVER_RANGE) pulse = RECEIVER_RANGE;
+            if (pulse < -RECEIVER_RANGE) pulse = -RECEIVER_RANGE;
+
+            // Store the channel in the back frame.
+            back = frame_front ^ 1;
+            frames[back].channels[pulse_index++] = pulse;
+
+            // Publish the frame once all channels are received.
+            if (pulse_index == RECEIVER_CHANNELS)
+            {
+                frames[back].sequence = frames[frame_front].sequence + 1;
+                frames[back].time = (uint16_t) (pulse_clock >> RECEIVER_TIME_SHIFT);
+                frame_front = back;
+            }
+        }
 
         // Clear all flags.
         TIFR1 = (1<<ICF1) | (1<<OCF1B) | (1<<OCF1A) | (1<<TOV1);
@@ -184,8 +232,8 @@ AVRX_SIGINT(SIG_INPUT_CAPTURE1)
         // Update OCR1A to avoid false trigger of sync flag.
         OCR1A = icr + MAX_DURATION;
 
-        // Signal that we received a rising pulse edge.
-        AvrXIntSetObjectSemaphore((pMutex) &receiver_timer);
+        // Count the pulse.
+        ++pulse_count;
     }
     else
     {
@@ -203,8 +251,4 @@ AVRX_SIGINT(SIG_INPUT_CAPTURE1)
         // Wait for rising edge.
         TCCR1B |= (1<<ICES1);
     }
-
-    // Go  back to RTOS
-    Epilog();
 }
-
@@ -25,41 +25,145 @@
 */
 
 #include <stdint.h>
+#include <string.h>
+#include <avr/pgmspace.h>
 #include "avrx.h"
 #include "balance.h"
+#include "config.h"
 #include "encoder.h"
+#include "fixed.h"
+#include "gainsched.h"
 #include "imu.h"
 #include "motor.h"
 #include "ipd.h"
+#include "safety.h"
+#include "statefb.h"
 
 #define DEFAULT_P_GAIN      ((int16_t) (03.14 * 256))
 #define DEFAULT_D_GAIN      ((int16_t) (00.00 * 256))
-#define DEFAULT_I_GAIN      ((int16_t) (02.15 * 256))
+// The integral gain was tuned with the balance loop running every 20
+// milliseconds.  It is scaled by the control period so the integral
+// accumulates at the same rate per second regardless of the loop rate.
+#define DEFAULT_I_GAIN      ((int16_t) (02.15 * 256 * CONTROL_PERIOD / 20))
 #define DEFAULT_T_COMP      ((int16_t) (-0.50 * 256))
 #define DEFAULT_MAX_VEL     ((int16_t) (160.00 * 128))
 
+// The state feedback angle and rate gains default to the equivalent of the
+// ipd integral and proportional gains.  The feedback acts on the wheel
+// acceleration so the rate gain is scaled by the control period.
+#define DEFAULT_SF_ANGLE    DEFAULT_I_GAIN
+#define DEFAULT_SF_RATE     ((int16_t) (03.14 * 256 * CONTROL_PERIOD / 1000))
+#define DEFAULT_SF_POSITION ((int16_t) (00.02 * 256))
+#define DEFAULT_SF_VELOCITY ((int16_t) (00.25 * 256))
+
+// The wheel position error is limited so a large displacement does not
+// overwhelm the balance terms.  In encoder units.
+#define BALANCE_MAX_POSITION    2000
+
+// Shift converting the tilt from the speed loop into a velocity reference
+// in encoder units per 10 milliseconds for the state feedback controller.
+#define BALANCE_TILT_SHIFT      4
+
+// Default gain schedule scale factors for the p and i gains as 8:8 fixed
+// point values.  Rows are pitch magnitude and columns wheel speed.  Both
+// default to unity so the fixed gains apply until a schedule is tuned
+// from the user interface.
+static const gainsched_table balance_p_schedule_default PROGMEM =
+{
+    // 0        16          32          48      encoder units / 10 ms
+    { 0x0100,   0x0100,     0x0100,     0x0100 },   // 0 degrees
+    { 0x0100,   0x0100,     0x0100,     0x0100 },   // 4 degrees
+    { 0x0100,   0x0100,     0x0100,     0x0100 },   // 8 degrees
+};
+static const gainsched_table balance_i_schedule_default PROGMEM =
+{
+    // 0        16          32          48      encoder units / 10 ms
+    { 0x0100,   0x0100,     0x0100,     0x0100 },   // 0 degrees
+    { 0x0100,   0x0100,     0x0100,     0x0100 },   // 4 degrees
+    { 0x0100,   0x0100,     0x0100,     0x0100 },   // 8 degrees
+};
+
 // Note: Assuming globals are zeroed.
 static int16_t balance_tilt;
 static int16_t balance_t_comp;
+static int16_t balance_p_gain;
+static int16_t balance_i_gain;
+static gainsched_table balance_p_schedule;
+static gainsched_table balance_i_schedule;
 static ipd balance_ipd;
+static uint8_t balance_mode;
+static statefb balance_statefb;
+static int32_t balance_position_ref;
 
 // Task control.
 AVRX_MUTEX(balance_mutex);
 
 void balance_init(void)
 {
-    // Initialize the pid gains and tilt compensation.
+    // Initialize the pid gains and tilt compensation.  The p and i gains
+    // are scaled by the gain schedule each update.
+    balance_p_gain = DEFAULT_P_GAIN;
+    balance_i_gain = DEFAULT_I_GAIN;
     ipd_set_p_gain(&balance_ipd, DEFAULT_P_GAIN);
     ipd_set_d_gain(&balance_ipd, DEFAULT_D_GAIN);
     ipd_set_i_gain(&balance_ipd, DEFAULT_I_GAIN);
     ipd_set_max_output(&balance_ipd, DEFAULT_MAX_VEL);
     balance_t_comp = DEFAULT_T_COMP;
 
+    // Load the default gain schedule.
+    memcpy_P(balance_p_schedule, balance_p_schedule_default, sizeof(gainsched_table));
+    memcpy_P(balance_i_schedule, balance_i_schedule_default, sizeof(gainsched_table));
+
+    // Initialize the state feedback gains.
+    statefb_set_gain(&balance_statefb, STATEFB_ANGLE, DEFAULT_SF_ANGLE);
+    statefb_set_gain(&balance_statefb, STATEFB_RATE, DEFAULT_SF_RATE);
+    statefb_set_gain(&balance_statefb, STATEFB_POSITION, DEFAULT_SF_POSITION);
+    statefb_set_gain(&balance_statefb, STATEFB_VELOCITY, DEFAULT_SF_VELOCITY);
+    statefb_set_max_output(&balance_statefb, DEFAULT_MAX_VEL);
+
     // Prime the balance mutex.
     AvrXSetSemaphore(&balance_mutex);
 }
 
 
+static int16_t balance_statefb_output(int16_t pitch_angle, int16_t pitch_rate,
+                                      int32_t position, int16_t velocity)
+// Determine the velocity output of the state feedback controller.  The
+// balance mutex must be held.
+{
+    int16_t state[STATEFB_STATES];
+    int16_t vel_ref;
+    int32_t position_error;
+
+    // The tilt from the speed loop sets the velocity reference and the
+    // position reference moves along with it.
+    vel_ref = balance_tilt >> BALANCE_TILT_SHIFT;
+    balance_position_ref += (int32_t) vel_ref * CONTROL_PERIOD / 10;
+
+    // Limit the position error by dragging the reference along.
+    position_error = position - balance_position_ref;
+    if (position_error > BALANCE_MAX_POSITION)
+    {
+        position_error = BALANCE_MAX_POSITION;
+        balance_position_ref = position - BALANCE_MAX_POSITION;
+    }
+    else if (position_error < -BALANCE_MAX_POSITION)
+    {
+        position_error = -BALANCE_MAX_POSITION;
+        balance_position_ref = position + BALANCE_MAX_POSITION;
+    }
+
+    // Fill in the state vector.  The tilt compensation adjusts the balance
+    // point for unbalanced loads on the robot.
+    state[STATEFB_ANGLE] = pitch_angle - balance_t_comp;
+    state[STATEFB_RATE] = pitch_rate;
+    state[STATEFB_POSITION] = (int16_t) position_error;
+    state[STATEFB_VELOCITY] = velocity - vel_ref;
+
+    return statefb_get_output(&balance_statefb, state);
+}
+
+
 void balance_update(void)
 // Main balance control loop.
 {
@@ -69,6 +173,15 @@ void balance_update(void)
     int16_t vel_output;
     int16_t pitch_angle;
     int16_t pitch_rate;
+    int16_t left_delta;
+    int16_t right_delta;
+    int16_t velocity;
+    int16_t scale;
+    uint16_t speed;
+    uint16_t pitch;
+    int32_t left_pos;
+    int32_t right_pos;
+    int32_t position;
 
     // By default set the motor velocity to zero.
     left_vel = 0;
@@ -80,29 +193,59 @@ void balance_update(void)
         // Get the IMU pitch values.
         imu_pitch_get(&pitch_angle, &pitch_rate);
 
-        // Make sure the limits are not exceeded.
-        if ((pitch_angle < 5120) && (pitch_angle > -5120))
-        {
-            // Get access to control values.
-            AvrXWaitSemaphore(&balance_mutex);
+        // Get the wheel position and the velocity in encoder units per
+        // 10 milliseconds.
+        encoder_get_positions(&left_pos, &right_pos);
+        encoder_get_deltas(&left_delta, &right_delta);
+        position = (left_pos + right_pos) >> 1;
+        velocity = ((left_delta + right_delta) >> 1) * (10 / CONTROL_PERIOD);
 
-            // Determine the proportional error from the balance tilt.  The tilt
-            // compensation is added in to adjust for unbalanced loads on the robot.
-            pitch_error = balance_tilt + balance_t_comp - pitch_angle;
+        // Get access to control values.
+        AvrXWaitSemaphore(&balance_mutex);
 
-            // Perform the ipd calculation.
-            vel_output = ipd_get_output(&balance_ipd, pitch_angle, pitch_error, pitch_rate);
+        // Make sure the limits are not exceeded.
+        if ((pitch_angle < SAFETY_PITCH_LIMIT) && (pitch_angle > -SAFETY_PITCH_LIMIT))
+        {
+            if (balance_mode == BALANCE_MODE_STATEFB)
+            {
+                // Perform the state feedback calculation.  The output is in the
+                // direction of wheel motion so it is negated to match the ipd.
+                vel_output = -balance_statefb_output(pitch_angle, pitch_rate, position, velocity);
+            }
+            else
+            {
+                // Schedule the p and i gains by the wheel speed and pitch magnitude.
+                speed = velocity < 0 ? -velocity : velocity;
+                pitch = pitch_angle < 0 ? -pitch_angle : pitch_angle;
+                scale = gainsched_lookup(balance_p_schedule, speed, pitch);
+                ipd_set_p_gain(&balance_ipd, fixed_sat16(fixed_mul_q8(balance_p_gain, scale)));
+                scale = gainsched_lookup(balance_i_schedule, speed, pitch);
+                ipd_set_i_gain(&balance_ipd, fixed_sat16(fixed_mul_q8(balance_i_gain, scale)));
+
+                // Determine the proportional error from the balance tilt.  The tilt
+                // compensation is added in to adjust for unbalanced loads on the robot.
+                pitch_error = balance_tilt + balance_t_comp - pitch_angle;
+
+                // Perform the ipd calculation.
+                vel_output = ipd_get_output(&balance_ipd, pitch_angle, pitch_error, pitch_rate);
+            }
 
             // Pull seven bits from the output.
             vel_output >>= 7;
 
-            // Release access to control values.
-            AvrXSetSemaphore(&balance_mutex);
-
     		// Set the PWM values for the left and right motor.
             left_vel = -vel_output;
             right_vel = -vel_output;
         }
+        else
+        {
+            // Restart the state feedback from the current position.
+            statefb_reset(&balance_statefb);
+            balance_position_ref = position;
+        }
+
+        // Release access to control values.
+        AvrXSetSemaphore(&balance_mutex);
     }
 
     // Set the velocity of the left and right motor.
@@ -125,6 +268,24 @@ void balance_tilt_set(int16_t tilt)
 }
 
 
+int16_t balance_tilt_get(void)
+// Get the balance tilt.
+{
+    int16_t tilt;
+
+    // Get access to control values.
+    AvrXWaitSemaphore(&balance_mutex);
+
+    // Get the tilt value.
+    tilt = balance_tilt;
+
+    // Release access to control values.
+    AvrXSetSemaphore(&balance_mutex);
+
+    return tilt;
+}
+
+
 void balance_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain, int16_t *t_comp)
 // Set the balance gains and tilt compensation.
 {
@@ -132,9 +293,9 @@ void balance_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain, int16_
     AvrXWaitSemaphore(&balance_mutex);
 
     // Set the balance gains and tilt compensation.
-    if (p_gain) ipd_set_p_gain(&balance_ipd, *p_gain);
+    if (p_gain) balance_p_gain = *p_gain;
     if (d_gain) ipd_set_d_gain(&balance_ipd, *d_gain);
-    if (i_gain) ipd_set_i_gain(&balance_ipd, *i_gain);
+    if (i_gain) balance_i_gain = *i_gain;
     if (t_comp) balance_t_comp = *t_comp;
 
     // Release access to control values.
@@ -149,9 +310,9 @@ void balance_gains_get(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain, int16_
     AvrXWaitSemaphore(&balance_mutex);
 
     // Set the gains.
-    if (p_gain) *p_gain = ipd_get_p_gain(&balance_ipd);
+    if (p_gain) *p_gain = balance_p_gain;
     if (d_gain) *d_gain = ipd_get_d_gain(&balance_ipd);
-    if (i_gain) *i_gain = ipd_get_i_gain(&balance_ipd);
+    if (i_gain) *i_gain = balance_i_gain;
     if (t_comp) *t_comp = balance_t_comp;
 
     // Release access to control values.
@@ -159,5 +320,109 @@ void balance_gains_get(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain, int16_
 }
 
 
+void balance_mode_set(uint8_t mode)
+// Select the ipd or state feedback balance controller.
+{
+    // Get access to control values.
+    AvrXWaitSemaphore(&balance_mutex);
+
+    // Restart the state feedback controller when it is selected.
+    if ((mode == BALANCE_MODE_STATEFB) && (balance_mode != BALANCE_MODE_STATEFB))
+    {
+        int32_t left_pos;
+        int32_t right_pos;
+
+        statefb_reset(&balance_statefb);
+        encoder_get_positions(&left_pos, &right_pos);
+        balance_position_ref = (left_pos + right_pos) >> 1;
+    }
+
+    // Set the mode.
+    balance_mode = mode;
+
+    // Release access to control values.
+    AvrXSetSemaphore(&balance_mutex);
+}
+
+
+uint8_t balance_mode_get(void)
+// Get the balance controller mode.
+{
+    return balance_mode;
+}
+
+
+void balance_statefb_gains_set(int16_t *angle_gain, int16_t *rate_gain, int16_t *position_gain, int16_t *velocity_gain)
+// Set the state feedback gains.
+{
+    // Get access to control values.
+    AvrXWaitSemaphore(&balance_mutex);
+
+    // Set the state feedback gains.
+    if (angle_gain) statefb_set_gain(&balance_statefb, STATEFB_ANGLE, *angle_gain);
+    if (rate_gain) statefb_set_gain(&balance_statefb, STATEFB_RATE, *rate_gain);
+    if (position_gain) statefb_set_gain(&balance_statefb, STATEFB_POSITION, *position_gain);
+    if (velocity_gain) statefb_set_gain(&balance_statefb, STATEFB_VELOCITY, *velocity_gain);
+
+    // Release access to control values.
+    AvrXSetSemaphore(&balance_mutex);
+}
+
+
+void balance_statefb_gains_get(int16_t *angle_gain, int16_t *rate_gain, int16_t *position_gain, int16_t *velocity_gain)
+// Get the state feedback gains.
+{
+    // Get access to control values.
+    AvrXWaitSemaphore(&balance_mutex);
+
+    // Get the state feedback gains.
+    if (angle_gain) *angle_gain = statefb_get_gain(&balance_statefb, STATEFB_ANGLE);
+    if (rate_gain) *rate_gain = statefb_get_gain(&balance_statefb, STATEFB_RATE);
+    if (position_gain) *position_gain = statefb_get_gain(&balance_statefb, STATEFB_POSITION);
+    if (velocity_gain) *velocity_gain = statefb_get_gain(&balance_statefb, STATEFB_VELOCITY);
+
+    // Release access to control values.
+    AvrXSetSemaphore(&balance_mutex);
+}
+
+
+void balance_schedule_set(uint8_t table, uint8_t pitch, uint8_t speed, int16_t scale)
+// Set a gain schedule scale factor.
+{
+    // Get access to control values.
+    AvrXWaitSemaphore(&balance_mutex);
+
+    // Set the scale factor.
+    if (table == BALANCE_SCHEDULE_P)
+        balance_p_schedule[pitch % GAINSCHED_PITCHES][speed % GAINSCHED_SPEEDS] = scale;
+    else
+        balance_i_schedule[pitch % GAINSCHED_PITCHES][speed % GAINSCHED_SPEEDS] = scale;
+
+    // Release access to control values.
+    AvrXSetSemaphore(&balance_mutex);
+}
+
+
+int16_t balance_schedule_get(uint8_t table, uint8_t pitch, uint8_t speed)
+// Get a gain schedule scale factor.
+{
+    int16_t scale;
+
+    // Get access to control values.
+    AvrXWaitSemaphore(&balance_mutex);
+
+    // Get the scale factor.
+    if (table == BALANCE_SCHEDULE_P)
+        scale = balance_p_schedule[pitch % GAINSCHED_PITCHES][speed % GAINSCHED_SPEEDS];
+    else
+        scale = balance_i_schedule[pitch % GAINSCHED_PITCHES][speed % GAINSCHED_SPEEDS];
+
+    // Release access to control values.
+    AvrXSetSemaphore(&balance_mutex);
+
+    return scale;
+}
+
+
 
 
@@ -27,10 +27,25 @@
 #ifndef _RB2_BALANCE_H_
 #define _RB2_BALANCE_H_ 1
 
+// Balance controller modes.
+#define BALANCE_MODE_IPD        0
+#define BALANCE_MODE_STATEFB    1
+
+// Balance gain schedule tables.
+#define BALANCE_SCHEDULE_P      0
+#define BALANCE_SCHEDULE_I      1
+
 void balance_init(void);
 void balance_update(void);
 void balance_tilt_set(int16_t tilt);
+int16_t balance_tilt_get(void);
 void balance_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain, int16_t *t_comp);
 void balance_gains_get(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain, int16_t *t_comp);
+void balance_mode_set(uint8_t mode);
+uint8_t balance_mode_get(void);
+void balance_statefb_gains_set(int16_t *angle_gain, int16_t *rate_gain, int16_t *position_gain, int16_t *velocity_gain);
+void balance_statefb_gains_get(int16_t *angle_gain, int16_t *rate_gain, int16_t *position_gain, int16_t *velocity_gain);
+void balance_schedule_set(uint8_t table, uint8_t pitch, uint8_t speed, int16_t scale);
+int16_t balance_schedule_get(uint8_t table, uint8_t pitch, uint8_t speed);
 
 #endif // _RB2_BALACNE_H_
@@ -0,0 +1,217 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Cycle benchmarks of the fixed point math and control kernels.  Each
+    benchmark repeats an operation on volatile operands and is timed with
+    the profile timer.  Interrupts stay enabled so the bus and telemetry
+    are serviced while the robot balances, and the shortest of several
+    runs is kept to leave out the runs that were interrupted.  The time
+    of an empty loop over the same operands is subtracted to leave the
+    cycles spent in the operation itself.
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "avrx.h"
+#include "bench.h"
+#include "fixed.h"
+#include "gainsched.h"
+#include "ipd.h"
+#include "pid.h"
+#include "pid2.h"
+#include "profile.h"
+#include "statefb.h"
+
+// Number of times each operation is repeated.
+#define BENCH_LOOPS         32
+
+// Number of timed runs of which the shortest is kept.
+#define BENCH_RUNS          16
+
+// Operands are volatile so the compiler cannot fold the operations.
+static volatile int16_t bench_a = 0x1234;
+static volatile int16_t bench_b = -0x0567;
+static volatile int32_t bench_a32 = 0x00012345L;
+static volatile int32_t bench_b32 = -0x00006789L;
+static volatile int32_t bench_result;
+
+// Cycle budgets of the kernels that run every control tick.  Zero means
+// no budget is set.
+static const uint16_t bench_budgets[BENCH_COUNT] PROGMEM =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, GAINSCHED_CYCLE_BUDGET
+};
+
+// Gain schedule with distinct values so no interpolation is trivial.
+static gainsched_table bench_schedule =
+{
+    { 0x0100, 0x0110, 0x0120, 0x0130 },
+    { 0x0140, 0x0150, 0x0160, 0x0170 },
+    { 0x0180, 0x0190, 0x01a0, 0x01b0 },
+};
+
+// Controller state used by the kernel benchmarks.
+static pid bench_pid;
+static pid bench_pid_right;
+static pid2 bench_pid2;
+static int16_t bench_pid2_output[PID2_CHANNELS];
+static ipd bench_ipd;
+static statefb bench_statefb;
+static int16_t bench_state[STATEFB_STATES] = { 0x0123, -0x0456, 0x0078, -0x0009 };
+
+static uint16_t bench_time(uint8_t bench)
+// Time the repeated operation in profile timer ticks.
+{
+    uint8_t i;
+    uint16_t start;
+
+    // Mark the start.
+    start = profile_time();
+
+    for (i = 0; i < BENCH_LOOPS; ++i)
+    {
+        switch (bench)
+        {
+            case BENCH_MUL32:
+                bench_result = bench_a32 * bench_b32;
+                break;
+            case BENCH_MUL16:
+                bench_result = fixed_mul16(bench_a, bench_b);
+                break;
+            case BENCH_FMUL15:
+                bench_result = fixed_fmul15(bench_a, bench_b);
+                break;
+            case BENCH_MAC16:
+                bench_result = fixed_mac16(bench_result, bench_a, bench_b);
+                break;
+            case BENCH_MUL_Q16:
+                bench_result = fixed_mul_q16(bench_a32, bench_b32);
+                break;
+            case BENCH_PID:
+                bench_result = pid_get_output(&bench_pid, bench_a, bench_b);
+                break;
+            case BENCH_PID_PAIR:
+                bench_result = pid_get_output(&bench_pid, bench_a, bench_b);
+                bench_result = pid_get_output(&bench_pid_right, bench_b, bench_a);
+                break;
+            case BENCH_PID2:
+                {
+                    int16_t error[PID2_CHANNELS] = { bench_a, bench_b };
+                    int16_t rate[PID2_CHANNELS] = { bench_b, bench_a };
+                    pid2_get_outputs(&bench_pid2, error, rate, bench_pid2_output);
+                    bench_result = bench_pid2_output[PID2_RIGHT];
+                }
+                break;
+            case BENCH_IPD:
+                bench_result = ipd_get_output(&bench_ipd, bench_a, bench_b, bench_a);
+                break;
+            case BENCH_STATEFB:
+                bench_result = statefb_get_output(&bench_statefb, bench_state);
+                break;
+            case BENCH_GAINSCHED:
+                bench_result = gainsched_lookup(bench_schedule, (uint16_t) bench_a & 0x3f, (uint16_t) bench_a & 0x0fff);
+                break;
+            default:
+                // Empty loop reading the same operands.
+                bench_result = bench_a + bench_b;
+                break;
+        }
+    }
+
+    // Return the elapsed time.
+    return profile_time() - start;
+}
+
+
+static uint16_t bench_time_min(uint8_t bench)
+// Time the repeated operation several times and return the shortest
+// time in profile timer ticks.
+{
+    uint8_t run;
+    uint16_t elapsed;
+    uint16_t shortest;
+
+    for (run = 0, shortest = 0xffff; run < BENCH_RUNS; ++run)
+    {
+        elapsed = bench_time(bench);
+        if (elapsed < shortest) shortest = elapsed;
+    }
+
+    return shortest;
+}
+
+
+uint16_t bench_run(uint8_t bench)
+// Run the benchmark and return the CPU cycles per operation.
+{
+    uint16_t ticks;
+    uint16_t overhead;
+
+    // Initialize the controllers with typical gains.
+    pid_init(&bench_pid);
+    pid_set_p_gain(&bench_pid, 0x0780);
+    pid_set_d_gain(&bench_pid, 0x0066);
+    pid_set_i_gain(&bench_pid, 0x0099);
+    pid_set_max_output(&bench_pid, 0x7f);
+    pid_set_max_integral(&bench_pid, 0xff);
+    bench_pid_right = bench_pid;
+    pid2_init(&bench_pid2);
+    pid2_set_p_gain(&bench_pid2, PID2_LEFT, 0x0780);
+    pid2_set_d_gain(&bench_pid2, PID2_LEFT, 0x0066);
+    pid2_set_i_gain(&bench_pid2, PID2_LEFT, 0x0099);
+    pid2_set_p_gain(&bench_pid2, PID2_RIGHT, 0x0780);
+    pid2_set_d_gain(&bench_pid2, PID2_RIGHT, 0x0066);
+    pid2_set_i_gain(&bench_pid2, PID2_RIGHT, 0x0099);
+    pid2_set_max_output(&bench_pid2, 0x7f);
+    pid2_set_max_integral(&bench_pid2, 0xff);
+    ipd_init(&bench_ipd);
+    ipd_set_p_gain(&bench_ipd, 0x0324);
+    ipd_set_d_gain(&bench_ipd, 0x0000);
+    ipd_set_i_gain(&bench_ipd, 0x0113);
+    ipd_set_max_output(&bench_ipd, 0x5000);
+    statefb_init(&bench_statefb);
+    statefb_set_gain(&bench_statefb, STATEFB_ANGLE, 0x0089);
+    statefb_set_gain(&bench_statefb, STATEFB_RATE, 0x0008);
+    statefb_set_gain(&bench_statefb, STATEFB_POSITION, 0x0005);
+    statefb_set_gain(&bench_statefb, STATEFB_VELOCITY, 0x0040);
+    statefb_set_max_output(&bench_statefb, 0x5000);
+
+    // Time the operation and the empty loop.
+    ticks = bench_time_min(bench);
+    overhead = bench_time_min(BENCH_COUNT);
+
+    // Convert the difference from profile timer ticks to cycles.
+    ticks = ticks > overhead ? ticks - overhead : 0;
+
+    return (uint16_t) (((uint32_t) ticks * 8) / BENCH_LOOPS);
+}
+
+
+uint16_t bench_budget_get(uint8_t bench)
+// Get the cycle budget of the benchmark or zero if none is set.
+{
+    return pgm_read_word_near(&bench_budgets[bench % BENCH_COUNT]);
+}
@@ -0,0 +1,49 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_BENCH_H_
+#define _RB2_BENCH_H_ 1
+
+#include <stdint.h>
+
+// Fixed point math benchmarks.
+#define BENCH_MUL32             0
+#define BENCH_MUL16             1
+#define BENCH_FMUL15            2
+#define BENCH_MAC16             3
+#define BENCH_MUL_Q16           4
+#define BENCH_PID               5
+#define BENCH_PID_PAIR          6
+#define BENCH_PID2              7
+#define BENCH_IPD               8
+#define BENCH_STATEFB           9
+#define BENCH_GAINSCHED         10
+#define BENCH_COUNT             11
+
+uint16_t bench_run(uint8_t bench);
+uint16_t bench_budget_get(uint8_t bench);
+
+#endif // _RB2_BENCH_H_
@@ -0,0 +1,232 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Blackbox of the last control ticks.  The state of each tick is written
+    into a ring buffer that is frozen by a fall, a user trigger or a
+    watchdog reset so the ticks leading up to the event can be read back
+    over the bus or streamed on the telemetry link.  The buffer is kept
+    in the .noinit section so its contents survive the watchdog reset.
+    The rb2_avr_boot128 bootloader returns straight to the application
+    after a watchdog reset it did not request and leaves the reset flags
+    set so the watchdog reset is seen here.  Writing a tick is a copy of
+    eight bytes and the ring index update.
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "avrx.h"
+#include "blackbox.h"
+#include "telemetry.h"
+
+// Marks the blackbox as valid across a reset.
+#define BLACKBOX_MAGIC          0xB1AC
+
+// Records sent in each telemetry frame of the dump.
+#define BLACKBOX_DUMP_RECORDS   8
+
+typedef struct
+{
+    uint16_t magic;
+    uint8_t head;               // Next record to write.
+    uint8_t count;              // Records held.
+    uint8_t state;              // Running or the freeze reason.
+    uint8_t pending;            // Reason of a requested freeze.
+    uint8_t post;               // Ticks left before a requested freeze.
+    blackbox_record records[BLACKBOX_RECORDS];
+} blackbox_log;
+
+// Not cleared at start up so a watchdog reset leaves the records intact.
+static blackbox_log blackbox __attribute__ ((section (".noinit")));
+
+// Next record of the frozen log to send on the telemetry link.
+static uint8_t blackbox_dump;
+
+
+void blackbox_reset(void)
+// Empty the blackbox and start recording.  This also rearms a frozen log.
+{
+    // Disable interrupts while the blackbox is reset.
+    cli();
+
+    blackbox.magic = BLACKBOX_MAGIC;
+    blackbox.head = 0;
+    blackbox.count = 0;
+    blackbox.state = BLACKBOX_RUNNING;
+    blackbox.pending = BLACKBOX_RUNNING;
+    blackbox.post = 0;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void blackbox_init(void)
+// Initialize the blackbox after a reset.  A blackbox that was recording
+// when the watchdog fired is frozen, one frozen before the reset is kept
+// and anything else is emptied.
+{
+    uint8_t reset_flags;
+
+    // Get and clear the reset flags.
+    reset_flags = MCUCSR;
+    MCUCSR = 0;
+
+    // Start over after power up or if the log was never valid.
+    if ((reset_flags & (1<<PORF)) ||
+        (blackbox.magic != BLACKBOX_MAGIC) ||
+        (blackbox.head >= BLACKBOX_RECORDS) ||
+        (blackbox.count > BLACKBOX_RECORDS))
+    {
+        blackbox_reset();
+    }
+    else if (blackbox.state == BLACKBOX_RUNNING)
+    {
+        // Keep the ticks before a watchdog reset.
+        if (reset_flags & (1<<WDRF))
+            blackbox.state = BLACKBOX_WATCHDOG;
+        else
+            blackbox_reset();
+    }
+
+    // A requested freeze did not complete before the reset.
+    blackbox.pending = BLACKBOX_RUNNING;
+    blackbox.post = 0;
+
+    // Send a frozen log on the telemetry link.
+    blackbox_dump = 0;
+}
+
+
+void blackbox_write(int16_t pitch_angle, int16_t pitch_rate, int16_t tilt, int8_t left_pwm, int8_t right_pwm)
+// Record the state of this control tick unless the blackbox is frozen.
+{
+    uint8_t head;
+    blackbox_record *record;
+
+    if (blackbox.state != BLACKBOX_RUNNING) return;
+
+    // Store the record.
+    head = blackbox.head;
+    record = &blackbox.records[head];
+    record->pitch_angle = pitch_angle;
+    record->pitch_rate = pitch_rate;
+    record->tilt = tilt;
+    record->left_pwm = left_pwm;
+    record->right_pwm = right_pwm;
+
+    // Advance the ring.
+    blackbox.head = (head == (BLACKBOX_RECORDS - 1)) ? 0 : head + 1;
+    if (blackbox.count < BLACKBOX_RECORDS) ++blackbox.count;
+
+    // Freeze once the ticks after a trigger are recorded.
+    if (blackbox.pending && !--blackbox.post)
+    {
+        blackbox.state = blackbox.pending;
+        blackbox_dump = 0;
+    }
+}
+
+
+void blackbox_trigger(uint8_t reason)
+// Request a freeze for the reason.  The blackbox keeps recording for a
+// few more ticks so the response to the event is captured as well.
+{
+    // Disable interrupts while the request is made.
+    cli();
+
+    // Only the first trigger counts.
+    if ((blackbox.state == BLACKBOX_RUNNING) && !blackbox.pending)
+    {
+        blackbox.pending = reason;
+        blackbox.post = BLACKBOX_POST_TICKS;
+    }
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void blackbox_dump_next(void)
+// Send the next part of a frozen log on the telemetry link.  Each frame
+// holds the freeze reason, the index of its first record counted from
+// the oldest and up to eight records.
+{
+    uint8_t i;
+    uint16_t index;
+    static uint8_t frame[2 + BLACKBOX_DUMP_RECORDS * sizeof(blackbox_record)];
+    uint8_t *dst;
+    uint8_t *src;
+    uint8_t size;
+
+    if ((blackbox.state == BLACKBOX_RUNNING) || (blackbox_dump >= blackbox.count)) return;
+
+    frame[0] = blackbox.state;
+    frame[1] = blackbox_dump;
+
+    // Copy the records oldest first.
+    dst = &frame[2];
+    for (i = 0; (i < BLACKBOX_DUMP_RECORDS) && (blackbox_dump + i < blackbox.count); ++i)
+    {
+        index = blackbox.head + BLACKBOX_RECORDS - blackbox.count + blackbox_dump + i;
+        if (index >= BLACKBOX_RECORDS) index -= BLACKBOX_RECORDS;
+        src = (uint8_t *) &blackbox.records[index];
+        for (size = 0; size < sizeof(blackbox_record); ++size) *(dst++) = *(src++);
+    }
+
+    // Move on only if the frame was queued.
+    if (telemetry_frame_send(TELEMETRY_FRAME_BLACKBOX, frame, dst - frame)) blackbox_dump += i;
+}
+
+
+uint8_t blackbox_state_get(void)
+// Get the blackbox state.
+{
+    return blackbox.state;
+}
+
+
+uint8_t blackbox_count_get(void)
+// Get the number of records held.
+{
+    return blackbox.count;
+}
+
+
+uint8_t blackbox_byte_get(uint16_t offset)
+// Get a byte of the records counted from the oldest.  Zero is returned
+// past the end of the records.
+{
+    uint16_t index;
+    uint8_t record;
+
+    // Find the record.
+    record = offset / sizeof(blackbox_record);
+    if ((offset >= (uint16_t) BLACKBOX_RECORDS * sizeof(blackbox_record)) || (record >= blackbox.count)) return 0;
+    index = blackbox.head + BLACKBOX_RECORDS - blackbox.count + record;
+    if (index >= BLACKBOX_RECORDS) index -= BLACKBOX_RECORDS;
+
+    return ((uint8_t *) &blackbox.records[index])[offset % sizeof(blackbox_record)];
+}
@@ -0,0 +1,62 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_BLACKBOX_H_
+#define _RB2_BLACKBOX_H_ 1
+
+// Number of control ticks kept in the blackbox.  At 10 milliseconds per
+// tick this is the last two seconds before the freeze.
+#define BLACKBOX_RECORDS        200
+
+// Ticks still recorded after a fall or user trigger before the freeze.
+#define BLACKBOX_POST_TICKS     20
+
+// Blackbox states.  Anything other than running is the freeze reason.
+#define BLACKBOX_RUNNING        0
+#define BLACKBOX_FALL           1
+#define BLACKBOX_WATCHDOG       2
+#define BLACKBOX_USER           3
+
+// State of the control loop recorded each tick.
+typedef struct
+{
+    int16_t pitch_angle;
+    int16_t pitch_rate;
+    int16_t tilt;
+    int8_t left_pwm;
+    int8_t right_pwm;
+} blackbox_record;
+
+void blackbox_init(void);
+void blackbox_write(int16_t pitch_angle, int16_t pitch_rate, int16_t tilt, int8_t left_pwm, int8_t right_pwm);
+void blackbox_trigger(uint8_t reason);
+void blackbox_reset(void);
+void blackbox_dump_next(void);
+uint8_t blackbox_state_get(void);
+uint8_t blackbox_count_get(void);
+uint8_t blackbox_byte_get(uint16_t offset);
+
+#endif // _RB2_BLACKBOX_H_
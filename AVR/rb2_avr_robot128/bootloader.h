@@ -29,17 +29,30 @@
 
 #include <avr/io.h>
 #include <avr/interrupt.h>
+#include <avr/wdt.h>
+
+// Byte address of the rb2_avr_boot128 bootloader in flash.
+#define BOOTLOADER_ADDRESS      0x1F800
 
 static inline void bootloader_start(void)
-// Start the the bootloader aborting the current application.
+// Start the the bootloader aborting the current application.  The
+// bootloader is entered with a jump rather than a watchdog reset so it
+// can tell a requested entry from a watchdog reset of a hung application.
+// The bootloader then resets the MCU itself.
 {
     // Clear interrupts.
     cli();
 
-    // Enable the watchdog with minimum prescaling.
-    WDTCR = (0<<WDCE) | (1<<WDE) | (0<<WDP2) | (0<<WDP1) | (0<<WDP0);
+    // Disable the control loop watchdog so it cannot reset the MCU first.
+    wdt_disable();
+
+    // Clear the reset flags so the bootloader sees a jump.
+    MCUCSR = 0;
+
+    // Jump to the bootloader.  Function pointers hold word addresses.
+    ((void (*)(void)) (BOOTLOADER_ADDRESS / 2))();
 
-    // Wait for reset to occur.
+    // Should never get here.
     for (;;);
 }
 
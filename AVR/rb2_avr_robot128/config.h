@@ -39,4 +39,32 @@
 // Define the timer queue tick rate in Hz.
 #define TICKRATE 1000
 
+// Define the control loop period in milliseconds.  The full balance
+// pipeline runs every period so 10 yields 100 Hz and 5 yields 200 Hz.
+#define CONTROL_PERIOD 10
+// #define CONTROL_PERIOD 5
+
+// Define the shift of the command low pass filters.  This keeps the
+// filter time constant near 160 milliseconds at the control period.
+#if (CONTROL_PERIOD == 5)
+#define CONTROL_FILTER_SHIFT 5
+#else
+#define CONTROL_FILTER_SHIFT 4
+#endif
+
+// Define the robot geometry used by the odometry.  These are placeholder
+// values and must be set for the actual hardware: the encoder counts per
+// wheel revolution, the wheel diameter in millimeters and the distance
+// between the wheel contact points in millimeters.
+#define ODOMETRY_COUNTS_PER_REV 4000
+#define ODOMETRY_WHEEL_DIAMETER 80.0
+#define ODOMETRY_WHEEL_BASE 200.0
+
+// Define as 1 to mirror every word on the RB2 bus into the telemetry
+// stream for analysis on the host with rb2_bus.  The mirror replaces the
+// control frames on the telemetry link, and words are still lost when
+// the bus is busier than the link.
+#define BUS_MIRROR 0
+// #define BUS_MIRROR 1
+
 #endif // _CONFIG_H_
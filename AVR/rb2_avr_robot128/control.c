@@ -27,18 +27,38 @@
 #include <stdint.h>
 #include <string.h>
 #include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <avr/wdt.h>
 #include "avrx.h"
 #include "balance.h"
+#include "blackbox.h"
+#include "config.h"
 #include "control.h"
 #include "encoder.h"
 #include "heading.h"
 #include "lcd.h"
 #include "motor.h"
+#include "odometry.h"
+#include "param.h"
 #include "imu.h"
 #include "pid.h"
+#include "profile.h"
+#include "rpc.h"
+#include "safety.h"
+#include "sched.h"
 #include "speed.h"
+#include "telemetry.h"
+#include "tick.h"
 #include "uio.h"
 
+// Control loop ticks between LED steps, user I/O polls and LCD updates.
+// The user I/O and LCD tick counts are job periods and must be powers of two.
+// The raw IMU values are read every fourth user I/O poll.
+#define LED_TICKS       (500 / CONTROL_PERIOD)
+#define UIO_TICKS       (40 / CONTROL_PERIOD)
+#define LCD_TICKS       (80 / CONTROL_PERIOD)
+#define IMU_RAW_POLLS   4
+
 // Note: Assuming globals are zeroed.
 
 // Task control.
@@ -50,7 +70,7 @@ static void led_update(void)
     static uint8_t sub_count;
 
     // Update the count and leds.
-    if (++count == 50)
+    if (++count == LED_TICKS)
     {
         // Set the leds.
         uio_leds_set((1 << sub_count));
@@ -64,10 +84,62 @@ static void led_update(void)
 }
 
 
+static void control_uio_update(void)
+// Poll the user I/O and the raw IMU values for display.
+{
+    static uint8_t polls;
+
+    //  Poll for user input from the user I/O module.
+    uio_update();
+
+    // Read the raw IMU values for display.
+    if (++polls == IMU_RAW_POLLS)
+    {
+        imu_raw_update();
+        polls = 0;
+    }
+}
+
+
+// The control jobs in the order they run within a tick.  The safety
+// checks run first so stale data cuts the motors before anything else
+// is sent on the bus.  The encoder values feed the odometry and the
+// speed control which produces the tilt for the balance control.  The
+// balance and heading controls set the motor velocities which the motor
+// control turns into PWM.  Parameter requests are applied after the
+// motors are updated so gains only change between ticks, and the
+// telemetry frame follows so it carries this tick's PWM.  These run
+// every tick while the user I/O and LCD jobs are phased so they never
+// share a tick.
+static const sched_job control_jobs[] PROGMEM =
+{
+    // Function             Period          Phase           Profile stage
+    { safety_update,        1,              0,              PROFILE_SAFETY },
+    { led_update,           1,              0,              PROFILE_LED },
+    { encoder_update,       1,              0,              PROFILE_ENCODER },
+    { odometry_update,      1,              0,              PROFILE_ODOMETRY },
+    { speed_update,         1,              0,              PROFILE_SPEED },
+    { balance_update,       1,              0,              PROFILE_BALANCE },
+    { heading_update,       1,              0,              PROFILE_HEADING },
+    { motor_update,         1,              0,              PROFILE_MOTOR },
+    { rpc_update,           1,              0,              PROFILE_RPC },
+    { telemetry_update,     1,              0,              PROFILE_TELEMETRY },
+    { control_uio_update,   UIO_TICKS,      UIO_TICKS / 2,  PROFILE_UIO },
+    { lcd_update,           LCD_TICKS,      LCD_TICKS / 2,  PROFILE_LCD },
+};
+
+#define CONTROL_JOB_COUNT   (sizeof(control_jobs) / sizeof(sched_job))
+
+// Check the periods and phases of the jobs that do not run every tick.
+#if !SCHED_JOB_VALID(UIO_TICKS, UIO_TICKS / 2) || !SCHED_JOB_VALID(LCD_TICKS, LCD_TICKS / 2)
+#error "Control job period must be a power of two with a phase less than the period"
+#endif
+
+
 NAKEDFUNC(control_task)
 // Main task for robot control.
 {
-    static uint8_t control_count;
+    static uint16_t tick_start;
 
     // Delay for 500 milliseconds to give other modules a 
     // chance to power up and be ready for communication.
@@ -85,6 +157,9 @@ NAKEDFUNC(control_task)
     // Initialize the encoder module.
     encoder_init();
 
+    // Initialize the odometry.
+    odometry_init();
+
     // Initialize the motor module.
     motor_init();
 
@@ -97,57 +172,47 @@ NAKEDFUNC(control_task)
     // Initialize the heading control.
     heading_init();
 
+    // Load the saved gains over the defaults.
+    param_init();
+
+    // Initialize the safety checks.
+    safety_init();
+
+    // Initialize the blackbox keeping the records of a watchdog reset.
+    blackbox_init();
+
+    // Initialize the telemetry stream.
+    telemetry_init();
+
+    // Initialize the control loop profiling.
+    profile_init();
+
+    // Initialize the control job schedule.
+    sched_init(control_jobs, CONTROL_JOB_COUNT);
+
+    // Start the hardware control tick.
+    tick_init();
+
+    // Reset the robot if the control loop stops running.  The rb2 task
+    // resets the watchdog while a bus master session blocks the loop.
+    wdt_enable(WDTO_120MS);
+
     // Main control loop.
     for (;;)
     {
-        // Start the 10 millisecond timer.
-        AvrXStartTimer(&control_timer, 10);
-
-        // Update the LEDs.
-        led_update();
-
-        // Collect and update the motor encoder values to determine the 
-        // position and velocity of each motor.  The encoder values are 
-        // used for closed loop velocity control of the motors as well as 
-        // determining robot position, speed and heading.
-        encoder_update();
-
-        // Only perform balancing PID loop every 20 milliseconds.
-        if ((control_count & 0x01) == 0x01)
-        {
-            // Update the speed control.  This produces a tilt value
-            // which is then passed to the balance control.
-            speed_update();
-
-            // Collect the IMU information and update the motor 
-            // velocity values for the left and right motors.
-            balance_update();
-
-            // Adjust the motor velocity values for heading.
-            heading_update();
-        }
-
-        // Send the latest PWM power settings to the left and right motors.
-        motor_update();
-
-        // Poll the I/O module every 160 milliseconds.
-        if ((control_count & 0x0f) == 0x00)
-        {
-            //  Poll for user input from the user I/O module.
-            uio_update();
-        }
-
-        // Update the LCD every 80 milliseconds.
-        if ((control_count & 0x07) == 0x04)
-        {
-            // Update the LCD.
-            lcd_update();
-        }
-
-    	// Wait for the remainder of the 10 milliseconds to elapse.
-        AvrXWaitTimer(&control_timer);
-
-        // Increment the control counter.
-        ++control_count;
+        // Wait for the hardware timer to release the next control tick.
+        tick_wait();
+
+        // The control loop is still running.
+        wdt_reset();
+
+        // Mark the start of the control loop.
+        tick_start = profile_time();
+
+        // Run the control jobs due on this tick.
+        sched_run();
+
+        // Account the time of the whole loop against the deadline.
+        profile_stop(PROFILE_LOOP, tick_start);
     }
 }
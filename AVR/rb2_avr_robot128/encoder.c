@@ -31,6 +31,7 @@
 #include <avr/io.h>
 #include "avrx.h"
 #include "encoder.h"
+#include "safety.h"
 #include "usart.h"
 
 // Task control.
@@ -73,6 +74,7 @@ void encoder_update(void)
 {
     int16_t left_encoder = 0;
     int16_t right_encoder = 0;
+    uint8_t fresh = 0;
 
     // Grab access to the USART.
     usart_grab_access();
@@ -109,11 +111,21 @@ void encoder_update(void)
 
         // Receive right encoder low byte.
         right_encoder = (right_encoder << 8) | usart_recv();
+
+        // The encoder counts are fresh unless the module stopped answering.
+        fresh = usart_timed_out_get() ? 0 : 1;
     }
 
     // Release access to the USART.
     usart_release_access();
 
+    // Keep the last deltas rather than see the counts jump if the read
+    // failed.  The safety checks cut the motors if this persists.
+    if (!fresh) return;
+
+    // Note fresh counts for the safety checks.
+    safety_encoder_sample();
+
     // We invert the position of the left motor to account for the
     // fact that the wheels are geomtrically opposed to each other
     // and we want the positive encoder value to move in the forward 
@@ -0,0 +1,186 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Fixed point math helpers for the control loops.  Q8.8 values are held
+    in 16 bit integers and Q16.16 values in 32 bit integers.  On the AVR
+    the 16x16 multiplies use the hardware MULS/MULSU and FMULS/FMULSU
+    instructions directly rather than the generic 32 bit multiply that
+    avr-gcc generates for widened operands.  Portable C is used elsewhere.
+*/
+
+#ifndef _RB2_FIXED_H_
+#define _RB2_FIXED_H_ 1
+
+#include <stdint.h>
+
+#define FIXED_INT32_MAX         ((int32_t) 0x7fffffffL)
+#define FIXED_INT32_MIN         ((int32_t) -0x7fffffffL - 1)
+
+inline static int32_t fixed_mul16(int16_t a, int16_t b)
+// Signed 16x16 to 32 bit multiply.
+{
+#if defined(__AVR__)
+    int32_t result;
+    uint8_t zero;
+
+    // See Atmel application note AVR201 for the details of this sequence.
+    __asm__ __volatile__ (
+        "clr    %[z]"           "\n\t"
+        "muls   %B[a], %B[b]"   "\n\t"
+        "movw   %C[r], r0"      "\n\t"
+        "mul    %A[a], %A[b]"   "\n\t"
+        "movw   %A[r], r0"      "\n\t"
+        "mulsu  %B[a], %A[b]"   "\n\t"
+        "sbc    %D[r], %[z]"    "\n\t"
+        "add    %B[r], r0"      "\n\t"
+        "adc    %C[r], r1"      "\n\t"
+        "adc    %D[r], %[z]"    "\n\t"
+        "mulsu  %B[b], %A[a]"   "\n\t"
+        "sbc    %D[r], %[z]"    "\n\t"
+        "add    %B[r], r0"      "\n\t"
+        "adc    %C[r], r1"      "\n\t"
+        "adc    %D[r], %[z]"    "\n\t"
+        "clr    r1"             "\n\t"
+        : [r] "=&r" (result), [z] "=&r" (zero)
+        : [a] "a" (a), [b] "a" (b)
+    );
+
+    return result;
+#else
+    return (int32_t) a * (int32_t) b;
+#endif
+}
+
+
+inline static int16_t fixed_fmul15(int16_t a, int16_t b)
+// Signed Q1.15 by Q1.15 multiply with a Q1.15 result.
+{
+#if defined(__AVR__)
+    int32_t result;
+    uint8_t zero;
+
+    // See Atmel application note AVR201 for the details of this sequence.
+    __asm__ __volatile__ (
+        "clr    %[z]"           "\n\t"
+        "fmuls  %B[a], %B[b]"   "\n\t"
+        "movw   %C[r], r0"      "\n\t"
+        "fmul   %A[a], %A[b]"   "\n\t"
+        "adc    %C[r], %[z]"    "\n\t"
+        "movw   %A[r], r0"      "\n\t"
+        "fmulsu %B[a], %A[b]"   "\n\t"
+        "sbc    %D[r], %[z]"    "\n\t"
+        "add    %B[r], r0"      "\n\t"
+        "adc    %C[r], r1"      "\n\t"
+        "adc    %D[r], %[z]"    "\n\t"
+        "fmulsu %B[b], %A[a]"   "\n\t"
+        "sbc    %D[r], %[z]"    "\n\t"
+        "add    %B[r], r0"      "\n\t"
+        "adc    %C[r], r1"      "\n\t"
+        "adc    %D[r], %[z]"    "\n\t"
+        "clr    r1"             "\n\t"
+        : [r] "=&r" (result), [z] "=&r" (zero)
+        : [a] "a" (a), [b] "a" (b)
+    );
+
+    return (int16_t) (result >> 16);
+#else
+    return (int16_t) (((int32_t) a * (int32_t) b) >> 15);
+#endif
+}
+
+
+inline static int32_t fixed_add32(int32_t a, int32_t b)
+// Saturating 32 bit add.
+{
+    int32_t sum;
+
+    // Add as unsigned values to avoid undefined signed overflow.
+    sum = (int32_t) ((uint32_t) a + (uint32_t) b);
+
+    // Overflow occurred if the operands have the same sign and the sum does not.
+    if (((a ^ b) >= 0) && ((sum ^ a) < 0)) sum = (a < 0) ? FIXED_INT32_MIN : FIXED_INT32_MAX;
+
+    return sum;
+}
+
+
+inline static int32_t fixed_mac16(int32_t acc, int16_t a, int16_t b)
+// Saturating multiply accumulate of a 16x16 product into a 32 bit accumulator.
+{
+    return fixed_add32(acc, fixed_mul16(a, b));
+}
+
+
+inline static int32_t fixed_mul_q8(int16_t value, int16_t gain)
+// Multiply a value by a Q8.8 gain.
+{
+    return fixed_mul16(value, gain) >> 8;
+}
+
+
+inline static int32_t fixed_mul_q16(int32_t a, int32_t b)
+// Multiply two Q16.16 values.  The result must fit within Q16.16.
+{
+    int16_t a_hi = (int16_t) (a >> 16);
+    int16_t b_hi = (int16_t) (b >> 16);
+    uint16_t a_lo = (uint16_t) a;
+    uint16_t b_lo = (uint16_t) b;
+    uint32_t result;
+
+    // Sum the partial products of the integer and fraction parts.
+    result = (uint32_t) fixed_mul16(a_hi, b_hi) << 16;
+    result += (uint32_t) ((int32_t) a_hi * (int32_t) b_lo);
+    result += (uint32_t) ((int32_t) b_hi * (int32_t) a_lo);
+    result += ((uint32_t) a_lo * (uint32_t) b_lo) >> 16;
+
+    return (int32_t) result;
+}
+
+
+inline static int32_t fixed_clamp32(int32_t value, int32_t limit)
+// Clamp a value to plus or minus the limit.
+{
+    if (value > limit) return limit;
+    if (value < -limit) return -limit;
+    return value;
+}
+
+
+inline static int16_t fixed_clamp16(int32_t value, int16_t limit)
+// Clamp a value to plus or minus the limit as a 16 bit value.
+{
+    return (int16_t) fixed_clamp32(value, limit);
+}
+
+
+inline static int16_t fixed_sat16(int32_t value)
+// Saturate a value to the 16 bit range.
+{
+    if (value > 32767) return 32767;
+    if (value < -32768) return -32768;
+    return (int16_t) value;
+}
+
+#endif // _RB2_FIXED_H_
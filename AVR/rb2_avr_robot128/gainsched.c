@@ -0,0 +1,88 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Gain schedule lookup.  A table of 8:8 fixed point values indexed by
+    wheel speed and pitch magnitude is interpolated linearly along both
+    axes.  The breakpoints are evenly spaced by a power of two so finding
+    the cell and the fractions takes only shifts and masks.
+*/
+
+#include <stdint.h>
+#include "fixed.h"
+#include "gainsched.h"
+
+inline static uint8_t gainsched_split(uint16_t value, uint8_t shift, uint8_t count, int16_t *fraction)
+// Split the value into the index of the lower breakpoint and the fraction
+// of the way to the next breakpoint in the range 0 to 256.
+{
+    uint16_t index = value >> shift;
+    uint16_t mask = (1 << shift) - 1;
+
+    // Hold the last entries beyond the last breakpoint.
+    if (index >= (uint16_t) (count - 1))
+    {
+        *fraction = 256;
+        return count - 2;
+    }
+
+    // Scale the remainder to 8 bits.
+    if (shift > 8)
+        *fraction = (value & mask) >> (shift - 8);
+    else
+        *fraction = (value & mask) << (8 - shift);
+
+    return (uint8_t) index;
+}
+
+
+inline static int16_t gainsched_lerp(int16_t a, int16_t b, int16_t fraction)
+// Interpolate between two values by a fraction in the range 0 to 256.
+{
+    return a + (int16_t) (fixed_mul16(b - a, fraction) >> 8);
+}
+
+
+int16_t gainsched_lookup(const gainsched_table table, uint16_t speed, uint16_t pitch)
+// Interpolate the table at the wheel speed and pitch magnitude.  The table
+// values must be positive so the differences between them fit 16 bits.
+{
+    uint8_t s;
+    uint8_t p;
+    int16_t speed_fraction;
+    int16_t pitch_fraction;
+    int16_t low;
+    int16_t high;
+
+    // Find the cell and the fractions along each axis.
+    s = gainsched_split(speed, GAINSCHED_SPEED_SHIFT, GAINSCHED_SPEEDS, &speed_fraction);
+    p = gainsched_split(pitch, GAINSCHED_PITCH_SHIFT, GAINSCHED_PITCHES, &pitch_fraction);
+
+    // Interpolate along the speed axis at the pitch breakpoints either side.
+    low = gainsched_lerp(table[p][s], table[p][s + 1], speed_fraction);
+    high = gainsched_lerp(table[p + 1][s], table[p + 1][s + 1], speed_fraction);
+
+    // Interpolate along the pitch axis.
+    return gainsched_lerp(low, high, pitch_fraction);
+}
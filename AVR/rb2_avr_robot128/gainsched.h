@@ -0,0 +1,48 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_GAINSCHED_H_
+#define _RB2_GAINSCHED_H_ 1
+
+#include <stdint.h>
+
+// Table breakpoints.  The wheel speed breakpoints are spaced 16 encoder
+// units per 10 milliseconds apart and the pitch breakpoints 4 degrees
+// apart in 8:8 fixed point.  Inputs beyond the last breakpoint use the
+// last table entries.
+#define GAINSCHED_SPEEDS        4
+#define GAINSCHED_PITCHES       3
+#define GAINSCHED_SPEED_SHIFT   4
+#define GAINSCHED_PITCH_SHIFT   10
+
+// Cycle budget for a single table lookup.
+#define GAINSCHED_CYCLE_BUDGET  200
+
+typedef int16_t gainsched_table[GAINSCHED_PITCHES][GAINSCHED_SPEEDS];
+
+int16_t gainsched_lookup(const gainsched_table table, uint16_t speed, uint16_t pitch);
+
+#endif // _RB2_GAINSCHED_H_
@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include "avrx.h"
 #include "balance.h"
+#include "config.h"
 #include "encoder.h"
 #include "heading.h"
 #include "motor.h"
@@ -43,34 +44,43 @@ void heading_init(void)
 
 
 void heading_update(void)
-// Main heading control loop.
+// Main heading control loop.  The RC value only changes with a new receiver
+// frame so the filter is skipped once it has settled on the last frame.
 {
-    int8_t heading_rc;
+    uint8_t sequence;
+    int16_t heading_rc;
     int16_t heading;
     int16_t left_motor_velocity;
     int16_t right_motor_velocity;
+    static int16_t heading_filtered;
+    static uint8_t heading_settled;
+    static uint8_t last_sequence;
     static int32_t heading_filter;
     
     // Get the motor velocities.
     motor_command_get(&left_motor_velocity, &right_motor_velocity);
 
-    // Get the RC control values.
-    uio_get_rc(&heading_rc, NULL);
+    // Get the full resolution RC control values.
+    sequence = uio_get_rc_wide(&heading_rc, NULL, NULL);
 
-    // Pass into a 16 bit variable for manipulation.
-    heading = heading_rc;
+    if ((sequence != last_sequence) || !heading_settled)
+    {
+        // Create a generous deadband for the heading.
+        if (heading_rc > 80) heading_rc -= 80;
+        else if (heading_rc < -80) heading_rc += 80;
+        else heading_rc = 0;
 
-    // Create a generous deadband for the heading.
-    if (heading > 10) heading -= 10;
-    else if (heading < -10) heading += 10;
-    else heading = 0;
+        // Pass the heading through a low pass filter to prevent wild swings.
+        heading_filter = heading_filter - (heading_filter >> CONTROL_FILTER_SHIFT) + heading_rc;
+        heading_filtered = (int16_t) (heading_filter >> CONTROL_FILTER_SHIFT);
 
-    // Pass the heading through a low pass filter to prevent wild swings.
-    heading_filter = heading_filter - (heading_filter >> 3) + heading;
-    heading = (int16_t) (heading_filter >> 3);
+        // The filter no longer changes once its output reaches its input.
+        heading_settled = (heading_filtered == heading_rc) ? 1 : 0;
+        last_sequence = sequence;
+    }
 
     // Convert the heading to a speed differential to be applied to the motor velocities.
-    heading = heading >> 2;
+    heading = heading_filtered >> 5;
 
     // Update the motor velocities.
     left_motor_velocity += heading;
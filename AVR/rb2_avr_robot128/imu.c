@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include "avrx.h"
 #include "imu.h"
+#include "safety.h"
 #include "usart.h"
 
 #define IMU_GET_COUNT       1
@@ -51,9 +52,13 @@ void imu_init(void)
 
 
 uint8_t imu_update(void)
-// Update the imu pitch angle and rate.
+// Update the imu pitch angle and rate.  A single burst command latches
+// the IMU values and returns the pitch angle and rate so the exchange
+// fits comfortably within the control period.
 {
     uint8_t rv = 0;
+    int16_t pitch_angle;
+    int16_t pitch_rate;
 
     // Grab access to the USART.
     usart_grab_access();
@@ -64,91 +69,91 @@ uint8_t imu_update(void)
     // Get and validate the response.
     if (usart_recv() == 0x00A5)
     {
-        // Latch the pitch angle and rate.
-        usart_xmit_discard_echo(0x00);
+        // Latch and read the pitch angle and rate.
+        usart_xmit_discard_echo(0x0b);
 
-        // Get and validate the response.
-        if (usart_recv() == 0x00A5)
+        // Receive the pitch angle bytes.
+        pitch_angle = (uint8_t) usart_recv();
+        pitch_angle = (pitch_angle << 8) | usart_recv();
+
+        // Receive the pitch rate bytes.
+        pitch_rate = (uint8_t) usart_recv();
+        pitch_rate = (pitch_rate << 8) | usart_recv();
+
+        // Keep the last values if the module stopped answering.
+        if (!usart_timed_out_get())
         {
             // Get exclusive access to the IMU values.
             AvrXWaitSemaphore(&imu_mutex);
 
-            // IMU Pitch Angle
-
-            // Get the first byte.
-            usart_xmit_discard_echo(0x01);
-
-            // Receive the first byte.
-            imu_pitch_angle = (uint8_t) usart_recv();
-
-            // Get the second byte.
-            usart_xmit_discard_echo(0x02);
-
-            // Receive the second byte.
-            imu_pitch_angle = (imu_pitch_angle << 8) | usart_recv();
-
-            // IMU Pitch Rate
-
-            // Get the first byte.
-            usart_xmit_discard_echo(0x03);
-
-            // Receive the first byte.
-            imu_pitch_rate = (uint8_t) usart_recv();
+            // Update the pitch angle and rate.
+            imu_pitch_angle = pitch_angle;
+            imu_pitch_rate = pitch_rate;
 
-            // Get the second byte.
-            usart_xmit_discard_echo(0x04);
-
-            // Receive the second byte.
-            imu_pitch_rate = (imu_pitch_rate << 8) | usart_recv();
-
-            // IMU Gyro X
+            // Give up exclusive access to the IMU values.
+            AvrXSetSemaphore(&imu_mutex);
 
-            // Get the first byte.
-            usart_xmit_discard_echo(0x05);
+            // We succeeded.
+            rv = 1;
+        }
+    }
 
-            // Receive the first byte.
-            imu_gyro_x = (uint8_t) usart_recv();
+    // Release access to the USART.
+    usart_release_access();
 
-            // Get the second byte.
-            usart_xmit_discard_echo(0x06);
+    // Check the new sample against the safety limits right away.
+    if (rv) safety_imu_sample(pitch_angle);
 
-            // Receive the second byte.
-            imu_gyro_x = (imu_gyro_x << 8) | usart_recv();
+    return rv;
+}
 
-            // IMU Accel Y
 
-            // Get the first byte.
-            usart_xmit_discard_echo(0x07);
+uint8_t imu_raw_update(void)
+// Update the imu gyro and accelerometer raw values.  These values are only
+// used for display so they are read at a slower rate than the pitch values.
+{
+    uint8_t rv = 0;
+    uint16_t gyro_x;
+    uint16_t accel_y;
+    uint16_t accel_z;
 
-            // Receive the first byte.
-            imu_accel_y = (uint8_t) usart_recv();
+    // Grab access to the USART.
+    usart_grab_access();
 
-            // Get the second byte.
-            usart_xmit_discard_echo(0x08);
+    // Select the IMU.
+    usart_xmit_discard_echo(0x0140);
 
-            // Receive the second byte.
-            imu_accel_y = (imu_accel_y << 8) | usart_recv();
+    // Get and validate the response.
+    if (usart_recv() == 0x00A5)
+    {
+        // Read the raw values latched with the last pitch values.
+        usart_xmit_discard_echo(0x0c);
 
-            // IMU Accel Z
+        // Receive the gyro x bytes.
+        gyro_x = (uint8_t) usart_recv();
+        gyro_x = (gyro_x << 8) | usart_recv();
 
-            // Get the first byte.
-            usart_xmit_discard_echo(0x09);
+        // Receive the accel y bytes.
+        accel_y = (uint8_t) usart_recv();
+        accel_y = (accel_y << 8) | usart_recv();
 
-            // Receive the first byte.
-            imu_accel_z = (uint8_t) usart_recv();
+        // Receive the accel z bytes.
+        accel_z = (uint8_t) usart_recv();
+        accel_z = (accel_z << 8) | usart_recv();
 
-            // Get the second byte.
-            usart_xmit_discard_echo(0x0a);
+        // Get exclusive access to the IMU values.
+        AvrXWaitSemaphore(&imu_mutex);
 
-            // Receive the second byte.
-            imu_accel_z = (imu_accel_z << 8) | usart_recv();
+        // Update the raw values.
+        imu_gyro_x = gyro_x;
+        imu_accel_y = accel_y;
+        imu_accel_z = accel_z;
 
-            // Give up exclusive access to the IMU values.
-            AvrXSetSemaphore(&imu_mutex);
+        // Give up exclusive access to the IMU values.
+        AvrXSetSemaphore(&imu_mutex);
 
-            // We succeeded.
-            rv = 1;
-        }
+        // We succeeded.
+        rv = 1;
     }
 
     // Release access to the USART.
@@ -29,6 +29,7 @@
 
 void imu_init(void);
 uint8_t imu_update(void);
+uint8_t imu_raw_update(void);
 void imu_pitch_get(int16_t *angle, int16_t *rate);
 void imu_raw_get(uint16_t *gyro_x, uint16_t *accel_y, uint16_t *accel_z);
 
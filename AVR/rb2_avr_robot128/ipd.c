@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "avrx.h"
+#include "fixed.h"
 #include "ipd.h"
 
 void ipd_init(ipd *self)
@@ -64,14 +65,14 @@ int16_t ipd_get_output(ipd *self, int16_t position, int16_t error, int16_t veloc
     // accumulator adjusting for multiplication.  Note: The command error is maintained 
     // with 32 bit precision in the accumulator although only the upper 24 bits are 
     // used for output calculations.
-    self->integral += (int32_t) error * (int32_t) self->i_gain;
+    self->integral = fixed_mac16(self->integral, error, self->i_gain);
 
     // Get the upper 24 bits of the integral output.
     output = (self->integral >> 8);
 
     // Get the position and velocity outputs.
-    position_output = ((int32_t) position * (int32_t) self->p_gain) >> 8;
-    velocity_output = ((int32_t) velocity * (int32_t) self->d_gain) >> 8;
+    position_output = fixed_mul_q8(position, self->p_gain);
+    velocity_output = fixed_mul_q8(velocity, self->d_gain);
 
     // The difference between the integral output minus the position output determines 
     // the direction and magnitude of the output while velocity output functions as a 
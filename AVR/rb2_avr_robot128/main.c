@@ -36,6 +36,7 @@
 AVRX_GCC_TASK(rb2_task, 50, 1);
 AVRX_GCC_TASK(control_task, 200, 2);
 AVRX_GCC_TASK(ui_task, 200, 3);
+AVRX_GCC_TASK(param_task, 200, 4);
 
 AVRX_SIGINT(TIMER0_COMP_vect)
 // System tick handler.
@@ -78,6 +79,7 @@ int main(void)
     AvrXRunTask(TCB(rb2_task));
     AvrXRunTask(TCB(control_task));
     AvrXRunTask(TCB(ui_task));
+    AvrXRunTask(TCB(param_task));
 
     // Switch from AvrX stack to first task.
     Epilog();
@@ -0,0 +1,128 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Mirror of the RB2 bus traffic on the telemetry stream.  Every 9 bit
+    word received on USART1, including the echo of each word sent, is
+    queued with its receive time and the queue is sent as bus frames from
+    the telemetry job.  Control frames are not sent while the mirror is
+    built in, which leaves the link to the mirror and any blackbox or
+    parameter frames.  Words that do not fit in the queue are counted and
+    the count is sent with the next frame.
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "mirror.h"
+#include "telemetry.h"
+
+// Queue size in words.  Must be a power of two no larger than 256.  This
+// holds the words of a busy tick while the link drains.
+#define MIRROR_QUEUE_SIZE       64
+#define MIRROR_QUEUE_MASK       (MIRROR_QUEUE_SIZE - 1)
+
+// Bytes in a mirrored word.
+#define MIRROR_ENTRY_SIZE       4
+
+// Note: Assuming globals are zeroed.
+
+// Queue of mirrored words.  Words are queued by whichever task reads the
+// USART so the queue is updated with interrupts disabled.
+static uint8_t mirror_queue[MIRROR_QUEUE_SIZE][MIRROR_ENTRY_SIZE];
+static uint8_t mirror_head;
+static uint8_t mirror_tail;
+static uint8_t mirror_lost;
+
+
+void mirror_word(uint16_t time, uint16_t data, uint8_t flags)
+// Queue a word received on the bus.
+{
+    uint8_t head;
+
+    // Include the ninth bit in the flags.
+    if (data & 0x0100) flags |= MIRROR_FLAG_BIT8;
+
+    // Disable interrupts while the queue is updated.
+    cli();
+
+    head = mirror_head;
+    if (((head + 1) & MIRROR_QUEUE_MASK) != mirror_tail)
+    {
+        mirror_queue[head][0] = time & 0xff;
+        mirror_queue[head][1] = time >> 8;
+        mirror_queue[head][2] = data & 0xff;
+        mirror_queue[head][3] = flags;
+        mirror_head = (head + 1) & MIRROR_QUEUE_MASK;
+    }
+    else
+    {
+        if (mirror_lost < 0xff) ++mirror_lost;
+    }
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void mirror_update(void)
+// Send the queued words in frames while they fit in the telemetry buffer.
+{
+    static uint8_t frame[1 + MIRROR_FRAME_WORDS * MIRROR_ENTRY_SIZE];
+    uint8_t i;
+    uint8_t words;
+    uint8_t room;
+
+    for (;;)
+    {
+        // Count the words queued.
+        cli();
+        words = (mirror_head - mirror_tail) & MIRROR_QUEUE_MASK;
+        sei();
+
+        // Send as many words as fit in the room left in the buffer.
+        room = telemetry_room_get();
+        if (room <= TELEMETRY_FRAME_OVERHEAD + 1) break;
+        room = (room - TELEMETRY_FRAME_OVERHEAD - 1) / MIRROR_ENTRY_SIZE;
+        if (words > room) words = room;
+        if (words > MIRROR_FRAME_WORDS) words = MIRROR_FRAME_WORDS;
+        if (words == 0) break;
+
+        // Copy the words from the queue.
+        cli();
+        frame[0] = mirror_lost;
+        mirror_lost = 0;
+        for (i = 0; i < words; ++i)
+        {
+            frame[1 + i * MIRROR_ENTRY_SIZE + 0] = mirror_queue[mirror_tail][0];
+            frame[1 + i * MIRROR_ENTRY_SIZE + 1] = mirror_queue[mirror_tail][1];
+            frame[1 + i * MIRROR_ENTRY_SIZE + 2] = mirror_queue[mirror_tail][2];
+            frame[1 + i * MIRROR_ENTRY_SIZE + 3] = mirror_queue[mirror_tail][3];
+            mirror_tail = (mirror_tail + 1) & MIRROR_QUEUE_MASK;
+        }
+        sei();
+
+        telemetry_frame_send(TELEMETRY_FRAME_BUS, frame, 1 + words * MIRROR_ENTRY_SIZE);
+    }
+}
@@ -0,0 +1,50 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_MIRROR_H_
+#define _RB2_MIRROR_H_ 1
+
+// Bus mirror frames hold a count of the words lost since the previous
+// frame followed by up to MIRROR_FRAME_WORDS entries of four bytes:
+//
+//   time_lo time_hi word_lo flags
+//
+// The time is the profile timer when the word was received, which runs
+// at the CPU clock divided by 8 and wraps every 32 milliseconds.  Words
+// sent by the robot are mirrored when their echo is received.  Stray or
+// late words flushed unread when the USART is grabbed are mirrored with
+// the time they were flushed.
+#define MIRROR_FRAME_WORDS      12
+
+// Entry flags.
+#define MIRROR_FLAG_BIT8        0x01        // Ninth bit of the word.
+#define MIRROR_FLAG_SENT        0x02        // Word sent by the robot.
+#define MIRROR_FLAG_FLUSHED     0x04        // Word flushed unread.
+
+void mirror_word(uint16_t time, uint16_t data, uint8_t flags);
+void mirror_update(void);
+
+#endif // _RB2_MIRROR_H_
@@ -27,22 +27,28 @@
 #include <stdint.h>
 #include <avr/io.h>
 #include "avrx.h"
+#include "config.h"
 #include "encoder.h"
 #include "motor.h"
-#include "pid.h"
+#include "pid2.h"
+#include "safety.h"
 #include "usart.h"
 
-// Default values.
+// The motor velocity is commanded in encoder units per 10 milliseconds so
+// the encoder deltas are scaled up when the control period is shorter.
+#define MOTOR_DELTA_SCALE       (10 / CONTROL_PERIOD)
+
+// Default values.  The derivative and integral gains were tuned with a
+// 10 millisecond control period and are scaled to the actual period.
 #define DEFAULT_P_GAIN          0x0780
-#define DEFAULT_D_GAIN          0x0066
-#define DEFAULT_I_GAIN          0x0099
+#define DEFAULT_D_GAIN          (0x0066 * 10 / CONTROL_PERIOD)
+#define DEFAULT_I_GAIN          (0x0099 * CONTROL_PERIOD / 10)
 #define DEFAULT_MAX_OUTPUT      0x7f
 #define DEFAULT_MAX_INTEGRAL    0xff
 
 // Note: Assuming globals are zeroed.
 static uint8_t motor_enabled;
-static pid motor_left_pid;
-static pid motor_right_pid;
+static pid2 motor_pid;
 static int8_t motor_left_pwm;
 static int8_t motor_right_pwm;
 static int16_t motor_left_cmd;
@@ -106,9 +112,9 @@ void motor_left_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain)
     AvrXWaitSemaphore(&motor_mutex);
 
     // Set the left gain values.
-    if (p_gain) pid_set_p_gain(&motor_left_pid, *p_gain);
-    if (d_gain) pid_set_d_gain(&motor_left_pid, *d_gain);
-    if (i_gain) pid_set_i_gain(&motor_left_pid, *i_gain);
+    if (p_gain) pid2_set_p_gain(&motor_pid, PID2_LEFT, *p_gain);
+    if (d_gain) pid2_set_d_gain(&motor_pid, PID2_LEFT, *d_gain);
+    if (i_gain) pid2_set_i_gain(&motor_pid, PID2_LEFT, *i_gain);
 
     // Release exclusive access to the motor variables.
     AvrXSetSemaphore(&motor_mutex);
@@ -122,9 +128,9 @@ void motor_left_gains_get(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain)
     AvrXWaitSemaphore(&motor_mutex);
 
     // Get the left gain values.
-    if (p_gain) *p_gain = pid_get_p_gain(&motor_left_pid);
-    if (d_gain) *d_gain = pid_get_d_gain(&motor_left_pid);
-    if (i_gain) *i_gain = pid_get_i_gain(&motor_left_pid);
+    if (p_gain) *p_gain = pid2_get_p_gain(&motor_pid, PID2_LEFT);
+    if (d_gain) *d_gain = pid2_get_d_gain(&motor_pid, PID2_LEFT);
+    if (i_gain) *i_gain = pid2_get_i_gain(&motor_pid, PID2_LEFT);
 
     // Release exclusive access to the motor variables.
     AvrXSetSemaphore(&motor_mutex);
@@ -138,9 +144,9 @@ void motor_right_gains_set(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain)
     AvrXWaitSemaphore(&motor_mutex);
 
     // Set the right gain values.
-    if (p_gain) pid_set_p_gain(&motor_right_pid, *p_gain);
-    if (d_gain) pid_set_d_gain(&motor_right_pid, *d_gain);
-    if (i_gain) pid_set_i_gain(&motor_right_pid, *i_gain);
+    if (p_gain) pid2_set_p_gain(&motor_pid, PID2_RIGHT, *p_gain);
+    if (d_gain) pid2_set_d_gain(&motor_pid, PID2_RIGHT, *d_gain);
+    if (i_gain) pid2_set_i_gain(&motor_pid, PID2_RIGHT, *i_gain);
 
     // Release exclusive access to the motor variables.
     AvrXSetSemaphore(&motor_mutex);
@@ -154,9 +160,9 @@ void motor_right_gains_get(int16_t *p_gain, int16_t *d_gain, int16_t *i_gain)
     AvrXWaitSemaphore(&motor_mutex);
 
     // Get the right gain values.
-    if (p_gain) *p_gain = pid_get_p_gain(&motor_right_pid);
-    if (d_gain) *d_gain = pid_get_d_gain(&motor_right_pid);
-    if (i_gain) *i_gain = pid_get_i_gain(&motor_right_pid);
+    if (p_gain) *p_gain = pid2_get_p_gain(&motor_pid, PID2_RIGHT);
+    if (d_gain) *d_gain = pid2_get_d_gain(&motor_pid, PID2_RIGHT);
+    if (i_gain) *i_gain = pid2_get_i_gain(&motor_pid, PID2_RIGHT);
 
     // Release exclusive access to the motor variables.
     AvrXSetSemaphore(&motor_mutex);
@@ -219,18 +225,18 @@ void motor_init(void)
 // Initialize motor control information.
 {
     // Initialize the left pid gains.
-    pid_set_p_gain(&motor_left_pid, DEFAULT_P_GAIN);
-    pid_set_d_gain(&motor_left_pid, DEFAULT_D_GAIN);
-    pid_set_i_gain(&motor_left_pid, DEFAULT_I_GAIN);
-    pid_set_max_output(&motor_left_pid, DEFAULT_MAX_OUTPUT);
-    pid_set_max_integral(&motor_left_pid, DEFAULT_MAX_INTEGRAL);
+    pid2_set_p_gain(&motor_pid, PID2_LEFT, DEFAULT_P_GAIN);
+    pid2_set_d_gain(&motor_pid, PID2_LEFT, DEFAULT_D_GAIN);
+    pid2_set_i_gain(&motor_pid, PID2_LEFT, DEFAULT_I_GAIN);
 
     // Initialize the right pid gains.
-    pid_set_p_gain(&motor_right_pid, DEFAULT_P_GAIN);
-    pid_set_d_gain(&motor_right_pid, DEFAULT_D_GAIN);
-    pid_set_i_gain(&motor_right_pid, DEFAULT_I_GAIN);
-    pid_set_max_output(&motor_right_pid, DEFAULT_MAX_OUTPUT);
-    pid_set_max_integral(&motor_right_pid, DEFAULT_MAX_INTEGRAL);
+    pid2_set_p_gain(&motor_pid, PID2_RIGHT, DEFAULT_P_GAIN);
+    pid2_set_d_gain(&motor_pid, PID2_RIGHT, DEFAULT_D_GAIN);
+    pid2_set_i_gain(&motor_pid, PID2_RIGHT, DEFAULT_I_GAIN);
+
+    // Initialize the limits shared by both wheels.
+    pid2_set_max_output(&motor_pid, DEFAULT_MAX_OUTPUT);
+    pid2_set_max_integral(&motor_pid, DEFAULT_MAX_INTEGRAL);
 
     // Prime the motor mutex.
     AvrXSetSemaphore(&motor_mutex);
@@ -240,53 +246,65 @@ void motor_init(void)
 void motor_update(void)
 // Main motor control function.  This should be called after the
 // motor encoder values have been updated with new information.
+// The velocity loops run here rather than in an rb2_avr_motor module
+// on the bus.  This robot is the only RB2 bus master and the module
+// has a single USART on the bus, so the module cannot write the
+// MidiMotor2 itself and its pwm would have to be fetched and written
+// from here, one tick late and with no saving in bus traffic.
 {
-    int8_t left_pwm;
-    int8_t right_pwm;
-    int16_t left_error;
-    int16_t right_error;
-    int16_t left_error_d;
-    int16_t right_error_d;
+    int16_t error[PID2_CHANNELS];
+    int16_t error_d[PID2_CHANNELS];
+    int16_t pwm[PID2_CHANNELS];
     int16_t encoder_left_delta;
     int16_t encoder_right_delta;
-    static int16_t prev_left_error;
-    static int16_t prev_right_error;
+    static int16_t prev_error[PID2_CHANNELS];
 
     // By default the pwm values are zeroed.
-    left_pwm = 0;
-    right_pwm = 0;
+    pwm[PID2_LEFT] = 0;
+    pwm[PID2_RIGHT] = 0;
 
-    // Is PWM enabled to the motors?
-    if (motor_enabled)
+    // Is PWM enabled to the motors and not cut by the safety checks?
+    if (motor_enabled && !safety_trips_get())
     {
         // Get the encoder deltas.
         encoder_get_deltas(&encoder_left_delta, &encoder_right_delta);
 
+        // Scale the deltas to encoder units per 10 milliseconds.
+        encoder_left_delta *= MOTOR_DELTA_SCALE;
+        encoder_right_delta *= MOTOR_DELTA_SCALE;
+
         // Get exclusive access to the motor variables.
         AvrXWaitSemaphore(&motor_mutex);
 
         // Determine left/right velocity error.
-        left_error = motor_left_cmd - encoder_left_delta;
-        right_error = motor_right_cmd - encoder_right_delta;
+        error[PID2_LEFT] = motor_left_cmd - encoder_left_delta;
+        error[PID2_RIGHT] = motor_right_cmd - encoder_right_delta;
 
         // Determine left/right velocity error derivative.
-        left_error_d = prev_left_error - left_error;
-        right_error_d = prev_right_error - right_error;
+        error_d[PID2_LEFT] = prev_error[PID2_LEFT] - error[PID2_LEFT];
+        error_d[PID2_RIGHT] = prev_error[PID2_RIGHT] - error[PID2_RIGHT];
 
         // Save the current velocity error.
-        prev_left_error = left_error;
-        prev_right_error = right_error;
+        prev_error[PID2_LEFT] = error[PID2_LEFT];
+        prev_error[PID2_RIGHT] = error[PID2_RIGHT];
 
-        // Process the error and error through the pid algorithm.
-        left_pwm = (int8_t) pid_get_output(&motor_left_pid, left_error, left_error_d);
-        right_pwm = (int8_t) pid_get_output(&motor_right_pid, right_error, right_error_d);
+        // Process both errors through the dual channel pid algorithm.
+        pid2_get_outputs(&motor_pid, error, error_d, pwm);
 
         // Release exclusive access to the motor variables.
         AvrXSetSemaphore(&motor_mutex);
     }
 
   	// Update motors with new PWM values.
-    motor_pwm_set(left_pwm, right_pwm);
+    motor_pwm_set((int8_t) pwm[PID2_LEFT], (int8_t) pwm[PID2_RIGHT]);
+}
+
+
+void motor_stop(void)
+// Cut the motors right away rather than on the next motor update.
+{
+    // Zero the PWM values.
+    motor_pwm_set(0, 0);
 }
 
 
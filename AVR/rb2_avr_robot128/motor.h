@@ -39,5 +39,6 @@ void motor_pwm_get(int8_t *left_pwm, int8_t *right_pwm);
 
 void motor_init(void);
 void motor_update(void);
+void motor_stop(void);
 
 #endif // _RB2_MOTOR_H_
@@ -0,0 +1,196 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Dead reckoning of the robot pose from the wheel encoders.  The x and y
+    position are held in millimeters as 16:16 fixed point values and the
+    heading as a 32 bit binary angle where a full turn wraps the counter.
+    The position is advanced along the heading at the middle of each tick
+    using a quarter wave sine table in program memory.
+*/
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "avrx.h"
+#include "config.h"
+#include "encoder.h"
+#include "fixed.h"
+#include "odometry.h"
+
+#define ODOMETRY_PI                 3.14159265
+#define ODOMETRY_MM_PER_COUNT       (ODOMETRY_PI * ODOMETRY_WHEEL_DIAMETER / ODOMETRY_COUNTS_PER_REV)
+
+// Millimeters per count of the summed wheel counts as a 0:16 fixed point
+// value.  The sum of the counts is twice the distance travelled.
+#define ODOMETRY_DISTANCE_SCALE     ((int16_t) (ODOMETRY_MM_PER_COUNT * 65536.0 / 2.0 + 0.5))
+
+// Binary angle per count of difference between the right and left wheels.
+#define ODOMETRY_HEADING_SCALE      ((int32_t) (ODOMETRY_MM_PER_COUNT / ODOMETRY_WHEEL_BASE * 4294967296.0 / (2.0 * ODOMETRY_PI) + 0.5))
+
+// First quadrant of the sine as 1:15 fixed point values.
+static const int16_t odometry_sin_table[257] PROGMEM =
+{
+        0,   201,   402,   603,   804,  1005,  1206,  1407,
+     1608,  1809,  2009,  2210,  2411,  2611,  2811,  3012,
+     3212,  3412,  3612,  3812,  4011,  4211,  4410,  4609,
+     4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,
+     6393,  6590,  6787,  6983,  7180,  7376,  7571,  7767,
+     7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,
+     9512,  9704,  9896, 10088, 10279, 10469, 10660, 10850,
+    11039, 11228, 11417, 11605, 11793, 11980, 12167, 12354,
+    12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+    14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269,
+    15447, 15624, 15800, 15976, 16151, 16326, 16500, 16673,
+    16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+    18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358,
+    19520, 19681, 19841, 20001, 20160, 20318, 20475, 20632,
+    20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+    22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028,
+    23170, 23312, 23453, 23593, 23732, 23870, 24008, 24144,
+    24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+    25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199,
+    26320, 26439, 26557, 26674, 26791, 26906, 27020, 27133,
+    27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+    28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803,
+    28899, 28993, 29086, 29178, 29269, 29359, 29448, 29535,
+    29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+    30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784,
+    30853, 30920, 30986, 31050, 31114, 31177, 31238, 31298,
+    31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+    31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099,
+    32138, 32177, 32214, 32251, 32286, 32319, 32352, 32383,
+    32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+    32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718,
+    32729, 32738, 32746, 32753, 32758, 32762, 32766, 32767,
+    32767
+};
+
+// Note: Assuming globals are zeroed.
+static int32_t odometry_x;
+static int32_t odometry_y;
+static uint32_t odometry_heading;
+
+// Task control.
+AVRX_MUTEX(odometry_mutex);
+
+int16_t odometry_sin(uint16_t angle)
+// Sine of a binary angle as a 1:15 fixed point value.
+{
+    uint8_t index = (uint8_t) (angle >> 6);
+    int16_t value;
+
+    // Mirror the index in the second and fourth quadrants.
+    if (angle & 0x4000)
+        value = pgm_read_word_near(&odometry_sin_table[256 - index]);
+    else
+        value = pgm_read_word_near(&odometry_sin_table[index]);
+
+    // Negate in the third and fourth quadrants.
+    return (angle & 0x8000) ? -value : value;
+}
+
+
+int16_t odometry_cos(uint16_t angle)
+// Cosine of a binary angle as a 1:15 fixed point value.
+{
+    return odometry_sin(angle + 0x4000);
+}
+
+
+void odometry_init(void)
+// Initialize the odometry module.
+{
+    // Prime the odometry mutex.
+    AvrXSetSemaphore(&odometry_mutex);
+}
+
+
+void odometry_update(void)
+// Advance the pose by the latest encoder deltas.
+{
+    int16_t left_delta;
+    int16_t right_delta;
+    int16_t distance;
+    int32_t turn;
+    uint16_t angle;
+
+    // Get the encoder deltas.
+    encoder_get_deltas(&left_delta, &right_delta);
+
+    // Distance travelled in 8:8 fixed point millimeters.
+    distance = (int16_t) (fixed_mul16(left_delta + right_delta, ODOMETRY_DISTANCE_SCALE) >> 8);
+
+    // Change in heading as a binary angle.
+    turn = (int32_t) (right_delta - left_delta) * ODOMETRY_HEADING_SCALE;
+
+    // Get exclusive access to the pose.
+    AvrXWaitSemaphore(&odometry_mutex);
+
+    // Heading at the middle of the tick.
+    angle = (uint16_t) ((odometry_heading + (turn >> 1)) >> 16);
+
+    // Advance the position.  The 8:8 distance times the 1:15 sine and
+    // cosine is shifted to 16:16 fixed point.
+    odometry_x += fixed_mul16(distance, odometry_cos(angle)) >> 7;
+    odometry_y += fixed_mul16(distance, odometry_sin(angle)) >> 7;
+
+    // Advance the heading.
+    odometry_heading += turn;
+
+    // Release exclusive access to the pose.
+    AvrXSetSemaphore(&odometry_mutex);
+}
+
+
+void odometry_reset(void)
+// Reset the pose to the origin.
+{
+    // Get exclusive access to the pose.
+    AvrXWaitSemaphore(&odometry_mutex);
+
+    // Reset the pose.
+    odometry_x = 0;
+    odometry_y = 0;
+    odometry_heading = 0;
+
+    // Release exclusive access to the pose.
+    AvrXSetSemaphore(&odometry_mutex);
+}
+
+
+void odometry_pose_get(int32_t *x, int32_t *y, uint16_t *heading)
+// Get the position in 16:16 fixed point millimeters and the heading as
+// a binary angle.
+{
+    // Get exclusive access to the pose.
+    AvrXWaitSemaphore(&odometry_mutex);
+
+    // Get the pose.
+    if (x) *x = odometry_x;
+    if (y) *y = odometry_y;
+    if (heading) *heading = (uint16_t) (odometry_heading >> 16);
+
+    // Release exclusive access to the pose.
+    AvrXSetSemaphore(&odometry_mutex);
+}
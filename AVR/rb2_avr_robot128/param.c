@@ -0,0 +1,262 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Parameter store.  The gains are loaded from EEPROM at start up and a
+    low priority task saves them again once they have been changed and
+    left alone.  The slot headers are read once and the newest slot with
+    a good CRC is then loaded with a block read.  Saving writes the oldest slot a byte at a time, sleeping
+    through each EEPROM write cycle, so an interrupted save leaves a slot
+    with a bad CRC and the previous save is loaded instead.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <avr/eeprom.h>
+#include <util/crc16.h>
+#include "avrx.h"
+#include "balance.h"
+#include "motor.h"
+#include "param.h"
+#include "speed.h"
+
+// Milliseconds between checks for changed parameters.  A change is only
+// saved once the parameters have been the same for two checks.
+#define PARAM_CHECK_PERIOD      1000
+
+// Milliseconds to sleep through an EEPROM write cycle.
+#define PARAM_WRITE_DELAY       9
+
+// Note: Assuming globals are zeroed.
+
+// Task control.
+AVRX_TIMER(param_timer);
+AVRX_MUTEX(param_ready);
+
+// The last saved slot and block.
+static uint8_t param_slot;
+static param_block param_saved;
+
+
+static uint16_t param_crc(const param_block *block)
+// Get the crc of the block excluding the crc itself.
+{
+    uint8_t i;
+    uint16_t crc = 0xffff;
+    const uint8_t *bytes = (const uint8_t *) block;
+
+    for (i = 0; i < offsetof(param_block, crc); ++i) crc = _crc_ccitt_update(crc, bytes[i]);
+
+    return crc;
+}
+
+
+static uint8_t *param_slot_address(uint8_t slot)
+// Get the EEPROM address of the slot.
+{
+    return (uint8_t *) (PARAM_EEPROM_BASE + (uint16_t) slot * sizeof(param_block));
+}
+
+
+static uint8_t param_load(void)
+// Load the newest block with a good crc into the saved block.  The
+// header of each slot is read once for its version and sequence, then
+// the newest slot is read as a block, falling back to older slots if its
+// crc is bad.  Returns 1 if a block was loaded.
+{
+    uint8_t i;
+    uint8_t best;
+    uint16_t best_sequence = 0;
+    uint16_t tried = 0;
+    static uint16_t sequences[PARAM_SLOTS];
+
+    // Get exclusive access to the EEPROM.
+    AvrXWaitSemaphore(&EEPromMutex);
+
+    // Read the header of each slot into the saved block, which is read
+    // over below, and skip the slots of another version.
+    for (i = 0; i < PARAM_SLOTS; ++i)
+    {
+        eeprom_read_block(&param_saved, param_slot_address(i), offsetof(param_block, values));
+        sequences[i] = param_saved.sequence;
+        if (param_saved.version != PARAM_VERSION) tried |= 1U << i;
+    }
+
+    for (;;)
+    {
+        // Find the untried slot with the newest sequence.
+        best = PARAM_SLOTS;
+        for (i = 0; i < PARAM_SLOTS; ++i)
+        {
+            if (tried & (1U << i)) continue;
+            if ((best == PARAM_SLOTS) || ((int16_t) (sequences[i] - best_sequence) > 0))
+            {
+                best = i;
+                best_sequence = sequences[i];
+            }
+        }
+
+        // No slot left to try.
+        if (best == PARAM_SLOTS) break;
+
+        // Read the whole block and check it.
+        eeprom_read_block(&param_saved, param_slot_address(best), sizeof(param_block));
+        if (param_saved.crc == param_crc(&param_saved))
+        {
+            param_slot = best;
+            break;
+        }
+
+        tried |= 1U << best;
+    }
+
+    // Release exclusive access to the EEPROM.
+    AvrXSetSemaphore(&EEPromMutex);
+
+    return best != PARAM_SLOTS;
+}
+
+
+static void param_save(int16_t *values)
+// Save the values to the slot after the last saved one.  Bytes already
+// holding the right value are not written.
+{
+    static uint8_t i;
+    static uint8_t *address;
+    static const uint8_t *bytes;
+
+    // Build the block.
+    param_saved.version = PARAM_VERSION;
+    param_saved.sequence += 1;
+    memcpy(param_saved.values, values, sizeof(param_saved.values));
+    param_saved.crc = param_crc(&param_saved);
+
+    // Move to the next slot.
+    param_slot = (param_slot + 1) % PARAM_SLOTS;
+    address = param_slot_address(param_slot);
+    bytes = (const uint8_t *) &param_saved;
+
+    // Write the block a byte at a time sleeping through each write cycle.
+    for (i = 0; i < sizeof(param_block); ++i)
+    {
+        if (AvrXReadEEProm(address + i) != bytes[i])
+        {
+            AvrXWriteEEProm(address + i, bytes[i]);
+            AvrXDelay(&param_timer, PARAM_WRITE_DELAY);
+        }
+    }
+}
+
+
+void param_values_get(int16_t *values)
+// Get the current value of every parameter.
+{
+    balance_gains_get(&values[PARAM_BALANCE_P], &values[PARAM_BALANCE_D],
+                      &values[PARAM_BALANCE_I], &values[PARAM_BALANCE_T_COMP]);
+    speed_gains_get(&values[PARAM_SPEED_P], &values[PARAM_SPEED_D], &values[PARAM_SPEED_I]);
+    motor_left_gains_get(&values[PARAM_MOTOR_LEFT_P], &values[PARAM_MOTOR_LEFT_D], &values[PARAM_MOTOR_LEFT_I]);
+    motor_right_gains_get(&values[PARAM_MOTOR_RIGHT_P], &values[PARAM_MOTOR_RIGHT_D], &values[PARAM_MOTOR_RIGHT_I]);
+    balance_statefb_gains_get(&values[PARAM_STATEFB_ANGLE], &values[PARAM_STATEFB_RATE],
+                              &values[PARAM_STATEFB_POSITION], &values[PARAM_STATEFB_VELOCITY]);
+}
+
+
+static int16_t *param_value(int16_t *values, uint32_t mask, uint8_t param)
+// Get the parameter value if its mask bit is set or NULL to leave it unchanged.
+{
+    return (mask & ((uint32_t) 1 << param)) ? &values[param] : NULL;
+}
+
+
+void param_values_set(int16_t *values, uint32_t mask)
+// Set the parameters whose bits are set in the mask.  Each group of gains
+// is set with a single call so its gains change together.
+{
+    balance_gains_set(param_value(values, mask, PARAM_BALANCE_P),
+                      param_value(values, mask, PARAM_BALANCE_D),
+                      param_value(values, mask, PARAM_BALANCE_I),
+                      param_value(values, mask, PARAM_BALANCE_T_COMP));
+    speed_gains_set(param_value(values, mask, PARAM_SPEED_P),
+                    param_value(values, mask, PARAM_SPEED_D),
+                    param_value(values, mask, PARAM_SPEED_I));
+    motor_left_gains_set(param_value(values, mask, PARAM_MOTOR_LEFT_P),
+                         param_value(values, mask, PARAM_MOTOR_LEFT_D),
+                         param_value(values, mask, PARAM_MOTOR_LEFT_I));
+    motor_right_gains_set(param_value(values, mask, PARAM_MOTOR_RIGHT_P),
+                          param_value(values, mask, PARAM_MOTOR_RIGHT_D),
+                          param_value(values, mask, PARAM_MOTOR_RIGHT_I));
+    balance_statefb_gains_set(param_value(values, mask, PARAM_STATEFB_ANGLE),
+                              param_value(values, mask, PARAM_STATEFB_RATE),
+                              param_value(values, mask, PARAM_STATEFB_POSITION),
+                              param_value(values, mask, PARAM_STATEFB_VELOCITY));
+}
+
+
+void param_init(void)
+// Load the saved parameters over the compiled in defaults.  This must be
+// called after the control modules are initialized.
+{
+    // Apply the saved parameters.  With nothing saved the defaults stand
+    // and the first save goes to the first slot.
+    if (param_load())
+    {
+        param_values_set(param_saved.values, 0xffffffff);
+    }
+    else
+    {
+        param_slot = PARAM_SLOTS - 1;
+        param_saved.sequence = 0;
+        param_values_get(param_saved.values);
+    }
+
+    // Let the parameter task run.
+    AvrXSetSemaphore(&param_ready);
+}
+
+
+NAKEDFUNC(param_task)
+// Low priority task saving changed parameters to EEPROM.
+{
+    static int16_t values[PARAM_COUNT];
+    static int16_t previous[PARAM_COUNT];
+
+    // Wait for the saved parameters to be loaded.
+    AvrXWaitSemaphore(&param_ready);
+
+    for (;;)
+    {
+        AvrXDelay(&param_timer, PARAM_CHECK_PERIOD);
+
+        // Save the parameters if they changed but have since settled.
+        param_values_get(values);
+        if (memcmp(values, param_saved.values, sizeof(values)) &&
+            !memcmp(values, previous, sizeof(values)))
+        {
+            param_save(values);
+        }
+
+        memcpy(previous, values, sizeof(previous));
+    }
+}
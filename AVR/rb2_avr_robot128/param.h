@@ -0,0 +1,75 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_PARAM_H_
+#define _RB2_PARAM_H_ 1
+
+#include "config.h"
+
+// Parameters.
+#define PARAM_BALANCE_P         0
+#define PARAM_BALANCE_D         1
+#define PARAM_BALANCE_I         2
+#define PARAM_BALANCE_T_COMP    3
+#define PARAM_SPEED_P           4
+#define PARAM_SPEED_D           5
+#define PARAM_SPEED_I           6
+#define PARAM_MOTOR_LEFT_P      7
+#define PARAM_MOTOR_LEFT_D      8
+#define PARAM_MOTOR_LEFT_I      9
+#define PARAM_MOTOR_RIGHT_P     10
+#define PARAM_MOTOR_RIGHT_D     11
+#define PARAM_MOTOR_RIGHT_I     12
+#define PARAM_STATEFB_ANGLE     13
+#define PARAM_STATEFB_RATE      14
+#define PARAM_STATEFB_POSITION  15
+#define PARAM_STATEFB_VELOCITY  16
+#define PARAM_COUNT             17
+
+// The parameter block is stored in a ring of EEPROM slots after the bus
+// address.  Each save goes to the next slot with the next sequence so
+// the writes are spread over all the slots.  The format must change
+// whenever the parameters change.  Some gains are in units of the control
+// period so the period is part of the version and gains saved with
+// another period are not loaded.
+#define PARAM_EEPROM_BASE       0x0010
+#define PARAM_SLOTS             16
+#define PARAM_FORMAT            1
+#define PARAM_VERSION           ((PARAM_FORMAT << 4) | CONTROL_PERIOD)
+
+typedef struct
+{
+    uint8_t version;
+    uint16_t sequence;
+    int16_t values[PARAM_COUNT];
+    uint16_t crc;
+} param_block;
+
+void param_init(void);
+void param_values_get(int16_t *values);
+void param_values_set(int16_t *values, uint32_t mask);
+
+#endif // _RB2_PARAM_H_
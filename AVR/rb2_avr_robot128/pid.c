@@ -27,6 +27,7 @@
 #include <stdint.h>
 #include <string.h>
 #include "avrx.h"
+#include "fixed.h"
 #include "pid.h"
 
 void pid_init(pid *self)
@@ -40,27 +41,22 @@ int16_t pid_get_output(pid *self, int16_t error, int16_t rate)
     int32_t output;
  
     // Perform the pid calculation to determine the desired velocity.
-    output = (int32_t) error * (int32_t) self->p_gain;
-    output -= (int32_t) rate * (int32_t) self->d_gain;
-    output += (int32_t) self->integral * (int32_t) self->i_gain;
+    output = fixed_mul16(error, self->p_gain);
+    output = fixed_add32(output, -fixed_mul16(rate, self->d_gain));
+    output = fixed_mac16(output, self->integral, self->i_gain);
 
     // Shift by the given shift adjustment and 8 bits to account for the fixed point gain.
     output >>= (self->shift + 8);
 
     // Range check the PWM output.
-    if (output > self->max_output) output = self->max_output;
-    if (output < -self->max_output) output = -self->max_output;
+    output = fixed_clamp32(output, self->max_output);
 
     // Decay the integral error.
     if (self->integral > 0) self->integral -= 1;
     if (self->integral < 0) self->integral += 1;
 
-    // Add the error to the integral.
-    self->integral += error;
-
-    // Range check the error integral.
-    if (self->integral > self->max_integral) self->integral = self->max_integral;
-    if (self->integral < -self->max_integral) self->integral = -self->max_integral;
+    // Add the error to the integral and range check the error integral.
+    self->integral = fixed_clamp16((int32_t) self->integral + error, self->max_integral);
 
     return (int16_t) output;
 }
@@ -0,0 +1,167 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Dual channel pid used for the left and right motor velocity loops.
+    Each channel is the same 8:8 fixed point pid with a decaying error
+    integral as the single channel pid without a shift, but both channels
+    are updated in one pass sharing the limit loads and clamps.  On the
+    AVR the three products of a channel are summed with hardware
+    multiplies into a 40 bit accumulator so the saturating 32 bit adds
+    are replaced by a single saturation of the sum.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "avrx.h"
+#include "fixed.h"
+#include "pid2.h"
+
+#if defined(__AVR__)
+inline static void pid2_mac(int32_t *acc, uint8_t *guard, int16_t a, int16_t b)
+// Add the signed 16x16 product to the 40 bit accumulator.
+{
+    uint8_t zero;
+    int32_t product;
+
+    // See Atmel application note AVR201 for the details of the multiply.
+    __asm__ __volatile__ (
+        "clr    %[z]"           "\n\t"
+        "muls   %B[a], %B[b]"   "\n\t"
+        "movw   %C[p], r0"      "\n\t"
+        "mul    %A[a], %A[b]"   "\n\t"
+        "movw   %A[p], r0"      "\n\t"
+        "mulsu  %B[a], %A[b]"   "\n\t"
+        "sbc    %D[p], %[z]"    "\n\t"
+        "add    %B[p], r0"      "\n\t"
+        "adc    %C[p], r1"      "\n\t"
+        "adc    %D[p], %[z]"    "\n\t"
+        "mulsu  %B[b], %A[a]"   "\n\t"
+        "sbc    %D[p], %[z]"    "\n\t"
+        "add    %B[p], r0"      "\n\t"
+        "adc    %C[p], r1"      "\n\t"
+        "adc    %D[p], %[z]"    "\n\t"
+        "add    %A[r], %A[p]"   "\n\t"
+        "adc    %B[r], %B[p]"   "\n\t"
+        "adc    %C[r], %C[p]"   "\n\t"
+        "adc    %D[r], %D[p]"   "\n\t"
+        "adc    %[g], %[z]"     "\n\t"
+        "sbrc   %D[p], 7"       "\n\t"
+        "dec    %[g]"           "\n\t"
+        "clr    r1"             "\n\t"
+        : [r] "+r" (*acc), [g] "+r" (*guard), [p] "=&r" (product), [z] "=&r" (zero)
+        : [a] "a" (a), [b] "a" (b)
+    );
+}
+
+
+inline static void pid2_msc(int32_t *acc, uint8_t *guard, int16_t a, int16_t b)
+// Subtract the signed 16x16 product from the 40 bit accumulator.
+{
+    uint8_t zero;
+    int32_t product;
+
+    // See Atmel application note AVR201 for the details of the multiply.
+    __asm__ __volatile__ (
+        "clr    %[z]"           "\n\t"
+        "muls   %B[a], %B[b]"   "\n\t"
+        "movw   %C[p], r0"      "\n\t"
+        "mul    %A[a], %A[b]"   "\n\t"
+        "movw   %A[p], r0"      "\n\t"
+        "mulsu  %B[a], %A[b]"   "\n\t"
+        "sbc    %D[p], %[z]"    "\n\t"
+        "add    %B[p], r0"      "\n\t"
+        "adc    %C[p], r1"      "\n\t"
+        "adc    %D[p], %[z]"    "\n\t"
+        "mulsu  %B[b], %A[a]"   "\n\t"
+        "sbc    %D[p], %[z]"    "\n\t"
+        "add    %B[p], r0"      "\n\t"
+        "adc    %C[p], r1"      "\n\t"
+        "adc    %D[p], %[z]"    "\n\t"
+        "sub    %A[r], %A[p]"   "\n\t"
+        "sbc    %B[r], %B[p]"   "\n\t"
+        "sbc    %C[r], %C[p]"   "\n\t"
+        "sbc    %D[r], %D[p]"   "\n\t"
+        "sbc    %[g], %[z]"     "\n\t"
+        "sbrc   %D[p], 7"       "\n\t"
+        "inc    %[g]"           "\n\t"
+        "clr    r1"             "\n\t"
+        : [r] "+r" (*acc), [g] "+r" (*guard), [p] "=&r" (product), [z] "=&r" (zero)
+        : [a] "a" (a), [b] "a" (b)
+    );
+}
+#endif
+
+
+void pid2_init(pid2 *self)
+{
+    // Zero out the pid2 structure.
+    memset(self, 0, sizeof(pid2));
+}
+
+
+void pid2_get_outputs(pid2 *self, const int16_t *error, const int16_t *rate, int16_t *output)
+// Update both channels from the error and error rate of each channel.
+{
+    uint8_t i;
+    int32_t sum;
+    int16_t integral;
+    int16_t max_output = self->max_output;
+    int16_t max_integral = self->max_integral;
+#if defined(__AVR__)
+    uint8_t guard;
+#endif
+
+    for (i = 0; i < PID2_CHANNELS; ++i)
+    {
+        integral = self->integral[i];
+
+#if defined(__AVR__)
+        // Sum the products in the 40 bit accumulator.
+        sum = 0;
+        guard = 0;
+        pid2_mac(&sum, &guard, error[i], self->p_gain[i]);
+        pid2_msc(&sum, &guard, rate[i], self->d_gain[i]);
+        pid2_mac(&sum, &guard, integral, self->i_gain[i]);
+
+        // Saturate if the guard byte is not the sign extension of the sum.
+        if (guard != (sum < 0 ? 0xff : 0x00)) sum = (guard & 0x80) ? FIXED_INT32_MIN : FIXED_INT32_MAX;
+#else
+        // Perform the pid calculation with saturating adds.
+        sum = fixed_mul16(error[i], self->p_gain[i]);
+        sum = fixed_add32(sum, -fixed_mul16(rate[i], self->d_gain[i]));
+        sum = fixed_mac16(sum, integral, self->i_gain[i]);
+#endif
+
+        // Shift to account for the fixed point gain and range check the output.
+        output[i] = (int16_t) fixed_clamp32(sum >> 8, max_output);
+
+        // Decay the integral error.
+        if (integral > 0) integral -= 1;
+        if (integral < 0) integral += 1;
+
+        // Add the error to the integral and range check the error integral.
+        self->integral[i] = fixed_clamp16((int32_t) integral + error[i], max_integral);
+    }
+}
@@ -0,0 +1,64 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_PID2_H_
+#define _RB2_PID2_H_ 1
+
+// Channels of the dual channel pid.
+#define PID2_LEFT               0
+#define PID2_RIGHT              1
+#define PID2_CHANNELS           2
+
+// The state of both channels is held as arrays so a single pass updates
+// both wheels.  The output and integral limits are shared by the channels.
+typedef struct
+{
+    int16_t p_gain[PID2_CHANNELS];
+    int16_t d_gain[PID2_CHANNELS];
+    int16_t i_gain[PID2_CHANNELS];
+    int16_t integral[PID2_CHANNELS];
+    int16_t max_output;
+    int16_t max_integral;
+} pid2;
+
+inline static int16_t pid2_get_p_gain(pid2 *self, uint8_t channel) { return self->p_gain[channel]; }
+inline static int16_t pid2_get_d_gain(pid2 *self, uint8_t channel) { return self->d_gain[channel]; }
+inline static int16_t pid2_get_i_gain(pid2 *self, uint8_t channel) { return self->i_gain[channel]; }
+inline static int16_t pid2_get_integral(pid2 *self, uint8_t channel) { return self->integral[channel]; }
+inline static int16_t pid2_get_max_output(pid2 *self) { return self->max_output; }
+inline static int16_t pid2_get_max_integral(pid2 *self) { return self->max_integral; }
+
+inline static void pid2_set_p_gain(pid2 *self, uint8_t channel, int16_t p_gain) { self->p_gain[channel] = p_gain; }
+inline static void pid2_set_d_gain(pid2 *self, uint8_t channel, int16_t d_gain) { self->d_gain[channel] = d_gain; }
+inline static void pid2_set_i_gain(pid2 *self, uint8_t channel, int16_t i_gain) { self->i_gain[channel] = i_gain; }
+inline static void pid2_set_integral(pid2 *self, uint8_t channel, int16_t integral) { self->integral[channel] = integral; }
+inline static void pid2_set_max_output(pid2 *self, int16_t max_output) { self->max_output = max_output; }
+inline static void pid2_set_max_integral(pid2 *self, int16_t max_integral) { self->max_integral = max_integral; }
+
+void pid2_init(pid2 *self);
+void pid2_get_outputs(pid2 *self, const int16_t *error, const int16_t *rate, int16_t *output);
+
+#endif // _RB2_PID2_H_
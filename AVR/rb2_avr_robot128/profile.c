@@ -0,0 +1,176 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Execution time profiling of the control loop stages.  Timer/counter3
+    free runs at the CPU clock divided by 8 and the stages are timed by
+    taking the difference of two counter samples.  The timer wraps every
+    32 milliseconds so stages longer than that will not be measured
+    correctly.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "avrx.h"
+#include "profile.h"
+
+// Number of samples averaged into each mean value.
+#define PROFILE_WINDOW      64
+
+typedef struct
+{
+    uint16_t min;
+    uint16_t max;
+    uint16_t mean;
+    uint16_t count;
+    uint32_t sum;
+    uint8_t window;
+} profile_stage;
+
+// Note: Assuming globals are zeroed.
+static uint16_t profile_misses;
+static profile_stage profile_stages[PROFILE_COUNT];
+
+void profile_reset(void)
+// Reset the profile statistics.
+{
+    uint8_t i;
+
+    // Disable interrupts while the statistics are reset.
+    cli();
+
+    // Reset the statistics for each stage.
+    memset(profile_stages, 0, sizeof(profile_stages));
+    for (i = 0; i < PROFILE_COUNT; ++i) profile_stages[i].min = 0xffff;
+
+    // Reset the missed deadlines.
+    profile_misses = 0;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void profile_init(void)
+// Initialize the profile timer and statistics.
+{
+    // Reset the statistics.
+    profile_reset();
+
+    // Initialize timer/counter3 to free run at clk/8.
+    TCNT3 = 0;
+    TCCR3A = (0<<COM3A1) | (0<<COM3A0) |                        // Disconnect OC3A.
+             (0<<COM3B1) | (0<<COM3B0) |                        // Disconnect OC3B.
+             (0<<COM3C1) | (0<<COM3C0) |                        // Disconnect OC3C.
+             (0<<WGM31) | (0<<WGM30);                           // Mode 0 - normal operation.
+    TCCR3B = (0<<ICNC3) | (0<<ICES3) |                          // No input capture.
+             (0<<WGM33) | (0<<WGM32) |                          // Mode 0 - normal operation.
+             (0<<CS32) | (1<<CS31) | (0<<CS30);                 // Clk/8.
+}
+
+
+uint16_t profile_stop(uint8_t stage, uint16_t start)
+// Account the time since start to the indicated stage.  The current
+// time is returned so the next stage can be timed from this point.
+{
+    uint16_t now;
+    uint16_t elapsed;
+    profile_stage *ps;
+
+    // Determine the elapsed time.
+    now = profile_time();
+    elapsed = now - start;
+
+    // Point to the stage.
+    ps = &profile_stages[stage];
+
+    // Disable interrupts while the statistics are updated.
+    cli();
+
+    // Update the minimum and maximum times.
+    if (elapsed < ps->min) ps->min = elapsed;
+    if (elapsed > ps->max) ps->max = elapsed;
+
+    // Accumulate the time until the window is full and then update the mean.
+    ps->sum += elapsed;
+    if (++ps->window == PROFILE_WINDOW)
+    {
+        ps->mean = (uint16_t) (ps->sum / PROFILE_WINDOW);
+        ps->sum = 0;
+        ps->window = 0;
+    }
+
+    // Count the samples.
+    if (ps->count < 0xffff) ++ps->count;
+
+    // Count the deadline misses for the whole loop.
+    if ((stage == PROFILE_LOOP) && (elapsed > PROFILE_DEADLINE) && (profile_misses < 0xffff)) ++profile_misses;
+
+    // Enable interrupts.
+    sei();
+
+    return now;
+}
+
+
+void profile_stats_get(uint8_t stage, profile_stats *stats)
+// Get the statistics for the indicated stage in profile timer ticks.
+{
+    profile_stage *ps;
+
+    // Point to the stage.
+    ps = &profile_stages[stage % PROFILE_COUNT];
+
+    // Disable interrupts while the statistics are copied.
+    cli();
+
+    // Copy the statistics.
+    stats->min = ps->count ? ps->min : 0;
+    stats->max = ps->max;
+    stats->mean = ps->mean;
+    stats->count = ps->count;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+uint16_t profile_misses_get(void)
+// Get the number of control loops that exceeded the deadline.
+{
+    uint16_t misses;
+
+    // Disable interrupts while the misses are read.
+    cli();
+
+    // Get the misses.
+    misses = profile_misses;
+
+    // Enable interrupts.
+    sei();
+
+    return misses;
+}
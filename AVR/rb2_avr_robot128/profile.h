@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_PROFILE_H_
+#define _RB2_PROFILE_H_ 1
+
+#include <avr/io.h>
+#include "config.h"
+
+// Profiled control loop stages.
+#define PROFILE_ENCODER         0
+#define PROFILE_SPEED           1
+#define PROFILE_BALANCE         2
+#define PROFILE_HEADING         3
+#define PROFILE_MOTOR           4
+#define PROFILE_UIO             5
+#define PROFILE_LCD             6
+#define PROFILE_LED             7
+#define PROFILE_ODOMETRY        8
+#define PROFILE_SAFETY          9
+#define PROFILE_TELEMETRY       10
+#define PROFILE_RPC             11
+#define PROFILE_LOOP            12
+#define PROFILE_COUNT           13
+
+// The profile timer runs at the CPU clock divided by 8.
+#define PROFILE_TICKS_PER_MS    (CPUCLK / 8 / 1000)
+#define PROFILE_TICKS_PER_US    (CPUCLK / 8 / 1000000)
+
+// The loop deadline in profile timer ticks.
+#define PROFILE_DEADLINE        (CONTROL_PERIOD * PROFILE_TICKS_PER_MS)
+
+typedef struct
+{
+    uint16_t min;
+    uint16_t max;
+    uint16_t mean;
+    uint16_t count;
+} profile_stats;
+
+inline static uint16_t profile_time(void) { return TCNT3; }
+
+void profile_init(void);
+void profile_reset(void);
+uint16_t profile_stop(uint8_t stage, uint16_t start);
+void profile_stats_get(uint8_t stage, profile_stats *stats);
+uint16_t profile_misses_get(void);
+
+#endif // _RB2_PROFILE_H_
@@ -29,10 +29,13 @@
 #include <stdint.h>
 #include <avr/interrupt.h>
 #include <avr/pgmspace.h>
+#include <avr/wdt.h>
 #include <string.h>
 #include "avrx.h"
 #include "config.h"
+#include "blackbox.h"
 #include "bootloader.h"
+#include "profile.h"
 #include "rb2.h"
 #include "usart.h"
 
@@ -44,6 +47,14 @@ static uint8_t rb2_address;
 static uint8_t rb2_id_index;
 static uint8_t rb2_address_pending;
 static uint8_t rb2_selected;
+static uint16_t rb2_blackbox_index;
+
+// Latched profile values.
+static uint16_t rb2_profile[4];
+
+// Longest wait in milliseconds for the bus master while selected.  This
+// must be well within the watchdog period.
+#define RB2_SELECTED_WAIT    40
 
 // The length of the following serial id string.
 #define ID_LENGTH    27
@@ -59,6 +70,25 @@ static void rb2_xmit_data(uint16_t data)
 }
 
 
+static uint16_t rb2_recv_selected(void)
+// Wait for the next word from the bus master while selected.  The
+// control task is blocked on the USART for the whole session and cannot
+// reset the watchdog, so it is reset here instead for as long as the
+// session lasts.
+{
+    uint16_t data;
+
+    do
+    {
+        // Keep the watchdog from resetting the robot during the session.
+        wdt_reset();
+    }
+    while ((data = usart_recv_timeout(RB2_SELECTED_WAIT)) == (uint16_t) -1);
+
+    return data;
+}
+
+
 static uint16_t rb2_recv_data(void)
 // Receive the next data word.  Returns error if the data
 // word is actually an address.
@@ -66,8 +96,8 @@ static uint16_t rb2_recv_data(void)
     // Do not receive more data if an address is pending.
     if (!rb2_address_pending)
     {
-        // Read the serial data ignoring any timeout.
-        rb2_data = usart_recv();
+        // Wait for the bus master to send the serial data.
+        rb2_data = rb2_recv_selected();
     }
 
     // Update the address pending flag.
@@ -84,8 +114,8 @@ static uint16_t rb2_recv_data_or_address(void)
     // Do not receive more data if an address is pending.
     if (!rb2_address_pending)
     {
-        // Read the serial data ignoring any timeout.
-        rb2_data = usart_recv();
+        // Wait for the bus master to send the serial data.
+        rb2_data = rb2_recv_selected();
     }
 
     // Reset the address pending flag.
@@ -161,6 +191,36 @@ static void rb2_address_set(void)
 }
 
 
+static void rb2_profile_latch(void)
+//  Handle the profile latch command.
+{
+    uint16_t data;
+    profile_stats stats;
+
+    // Send the response.
+    rb2_xmit_data(0x00A5);
+
+    // Wait for serial data.
+    data = rb2_recv_data();
+
+    // Make sure no error.
+    if (data != -1)
+    {
+        // Get the statistics for the indicated stage.
+        profile_stats_get((uint8_t) data, &stats);
+
+        // Latch the minimum, mean and maximum times and the missed deadlines.
+        rb2_profile[0] = stats.min;
+        rb2_profile[1] = stats.mean;
+        rb2_profile[2] = stats.max;
+        rb2_profile[3] = profile_misses_get();
+
+        // Send the stage as the response.
+        rb2_xmit_data(data);
+    }
+}
+
+
 NAKEDFUNC(rb2_task)
 // Task to process the RoboBricks2 protocol.
 {
@@ -212,6 +272,65 @@ NAKEDFUNC(rb2_task)
                     // We are no longer selected.
                     rb2_selected = 0;
                 }
+                else if (data == 0x10)
+                {
+                    // We received PROFILE LATCH command.
+                    rb2_profile_latch();
+                }
+                else if ((data >= 0x11) && (data <= 0x18))
+                {
+                    // Send the high or low byte of the latched profile value.
+                    data -= 0x11;
+                    rb2_xmit_data((data & 0x01) ? rb2_profile[data >> 1] & 0xff : rb2_profile[data >> 1] >> 8);
+                }
+                else if (data == 0x19)
+                {
+                    // We received PROFILE RESET command.
+                    profile_reset();
+
+                    // Send response.
+                    rb2_xmit_data(0x00A5);
+                }
+                else if (data == 0x1A)
+                {
+                    // We received BLACKBOX FREEZE command.
+                    blackbox_trigger(BLACKBOX_USER);
+
+                    // Send response.
+                    rb2_xmit_data(0x00A5);
+                }
+                else if (data == 0x1B)
+                {
+                    // We received BLACKBOX START command.
+
+                    // Reset the blackbox read index.
+                    rb2_blackbox_index = 0;
+
+                    // Send response which is the blackbox state.
+                    rb2_xmit_data(blackbox_state_get());
+                }
+                else if (data == 0x1C)
+                {
+                    // We received BLACKBOX COUNT command.
+
+                    // Send response which is the number of records.
+                    rb2_xmit_data(blackbox_count_get());
+                }
+                else if (data == 0x1D)
+                {
+                    // We received BLACKBOX NEXT command.
+
+                    // Send the next byte of the records.
+                    rb2_xmit_data(blackbox_byte_get(rb2_blackbox_index++));
+                }
+                else if (data == 0x1E)
+                {
+                    // We received BLACKBOX REARM command.
+                    blackbox_reset();
+
+                    // Send response.
+                    rb2_xmit_data(0x00A5);
+                }
                 else if (data == 0xff)
                 {
                     // We are being deselected.
@@ -251,6 +370,9 @@ NAKEDFUNC(rb2_task)
                     // Send response.
                     rb2_xmit_data(0x00A5);
 
+                    // Keep the bootloader reset from freezing the blackbox.
+                    blackbox_reset();
+
                     // Start the bootloader immediately.
                     bootloader_start();
                 }
@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Parameter reads and writes requested over the telemetry link.  The
+    received bytes are parsed by a control job so the gains change between
+    control ticks through the usual gain setters and the reply goes out on
+    the telemetry link with the tick's frames.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <util/crc16.h>
+#include "avrx.h"
+#include "param.h"
+#include "rpc.h"
+#include "telemetry.h"
+
+// Request parser states.
+#define RPC_SYNC1               0
+#define RPC_SYNC2               1
+#define RPC_TYPE                2
+#define RPC_LENGTH              3
+#define RPC_SEQ_LO              4
+#define RPC_SEQ_HI              5
+#define RPC_PAYLOAD             6
+#define RPC_CRC_LO              7
+#define RPC_CRC_HI              8
+
+// Note: Assuming globals are zeroed.
+
+// Request parser.
+static uint8_t rpc_state;
+static uint8_t rpc_type;
+static uint8_t rpc_length;
+static uint8_t rpc_count;
+static uint16_t rpc_sequence;
+static uint16_t rpc_crc;
+static uint8_t rpc_request[RPC_MAX_PAYLOAD];
+
+// Parameter values and the parameters written by the request.
+static int16_t rpc_values[PARAM_COUNT];
+static uint32_t rpc_written;
+
+// Reply with room for a value for each read in the largest request.
+static uint8_t rpc_reply[3 + (RPC_MAX_PAYLOAD / 2) * 3];
+
+
+static void rpc_execute(void)
+// Execute the received request and queue the reply.
+{
+    uint8_t i;
+    uint8_t op;
+    uint8_t param;
+    uint8_t status;
+    uint8_t length;
+
+    // Validate the request and stage the written values.
+    status = RPC_OK;
+    rpc_written = 0;
+    for (i = 0; (status == RPC_OK) && (i < rpc_length); )
+    {
+        op = rpc_request[i];
+        if ((op == RPC_OP_READ) && (i + 2 <= rpc_length))
+        {
+            if (rpc_request[i + 1] >= PARAM_COUNT) status = RPC_BAD_PARAM;
+            i += 2;
+        }
+        else if ((op == RPC_OP_WRITE) && (i + 4 <= rpc_length))
+        {
+            param = rpc_request[i + 1];
+            if (param < PARAM_COUNT)
+            {
+                rpc_values[param] = (int16_t) (rpc_request[i + 2] | (rpc_request[i + 3] << 8));
+                rpc_written |= (uint32_t) 1 << param;
+            }
+            else
+            {
+                status = RPC_BAD_PARAM;
+            }
+            i += 4;
+        }
+        else
+        {
+            status = RPC_BAD_REQUEST;
+        }
+    }
+
+    // Apply the writes only if the whole request is valid.
+    if ((status == RPC_OK) && rpc_written) param_values_set(rpc_values, rpc_written);
+
+    // Reply with the current value of each parameter in the request.
+    rpc_reply[0] = rpc_sequence & 0xff;
+    rpc_reply[1] = rpc_sequence >> 8;
+    rpc_reply[2] = status;
+    length = 3;
+    if (status == RPC_OK)
+    {
+        param_values_get(rpc_values);
+        for (i = 0; i < rpc_length; i += (rpc_request[i] == RPC_OP_WRITE) ? 4 : 2)
+        {
+            param = rpc_request[i + 1];
+            rpc_reply[length++] = param;
+            rpc_reply[length++] = (uint16_t) rpc_values[param] & 0xff;
+            rpc_reply[length++] = (uint16_t) rpc_values[param] >> 8;
+        }
+    }
+
+    telemetry_frame_send(TELEMETRY_FRAME_PARAM, rpc_reply, length);
+}
+
+
+void rpc_update(void)
+// Parse the bytes received on the telemetry link and execute any request.
+{
+    uint8_t data;
+
+    while (telemetry_recv(&data))
+    {
+        switch (rpc_state)
+        {
+            case RPC_SYNC1:
+                if (data == TELEMETRY_SYNC1) rpc_state = RPC_SYNC2;
+                break;
+            case RPC_SYNC2:
+                if (data == TELEMETRY_SYNC2) rpc_state = RPC_TYPE;
+                else if (data != TELEMETRY_SYNC1) rpc_state = RPC_SYNC1;
+                break;
+            case RPC_TYPE:
+                rpc_type = data;
+                rpc_crc = _crc_ccitt_update(0xffff, data);
+                rpc_state = RPC_LENGTH;
+                break;
+            case RPC_LENGTH:
+                rpc_length = data;
+                rpc_crc = _crc_ccitt_update(rpc_crc, data);
+                rpc_state = (data <= RPC_MAX_PAYLOAD) ? RPC_SEQ_LO : RPC_SYNC1;
+                break;
+            case RPC_SEQ_LO:
+                rpc_sequence = data;
+                rpc_crc = _crc_ccitt_update(rpc_crc, data);
+                rpc_state = RPC_SEQ_HI;
+                break;
+            case RPC_SEQ_HI:
+                rpc_sequence |= (uint16_t) data << 8;
+                rpc_crc = _crc_ccitt_update(rpc_crc, data);
+                rpc_count = 0;
+                rpc_state = rpc_length ? RPC_PAYLOAD : RPC_CRC_LO;
+                break;
+            case RPC_PAYLOAD:
+                rpc_request[rpc_count++] = data;
+                rpc_crc = _crc_ccitt_update(rpc_crc, data);
+                if (rpc_count == rpc_length) rpc_state = RPC_CRC_LO;
+                break;
+            case RPC_CRC_LO:
+                rpc_crc ^= data;
+                rpc_state = RPC_CRC_HI;
+                break;
+            case RPC_CRC_HI:
+                rpc_crc ^= (uint16_t) data << 8;
+                rpc_state = RPC_SYNC1;
+
+                // Execute a parameter request with a good crc.
+                if (!rpc_crc && (rpc_type == TELEMETRY_FRAME_PARAM)) rpc_execute();
+                break;
+        }
+    }
+}
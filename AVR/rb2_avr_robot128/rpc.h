@@ -0,0 +1,61 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_RPC_H_
+#define _RB2_RPC_H_ 1
+
+#include "param.h"
+
+// Parameter requests and replies are telemetry frames of the parameter
+// type.  A request payload is a list of operations:
+//
+//   read:   RPC_OP_READ param
+//   write:  RPC_OP_WRITE param value_lo value_hi
+//
+// All writes of a request are applied together between two control ticks
+// or none are applied if any operation is invalid.  The reply payload is
+// the request sequence and a status followed by the parameter and its
+// current value for each operation:
+//
+//   seq_lo seq_hi status [param value_lo value_hi]...
+//
+// The parameters are numbered as in param.h.
+
+// Largest request payload.
+#define RPC_MAX_PAYLOAD         48
+
+// Operations.
+#define RPC_OP_READ             0x01
+#define RPC_OP_WRITE            0x02
+
+// Reply status.
+#define RPC_OK                  0x00
+#define RPC_BAD_PARAM           0x01
+#define RPC_BAD_REQUEST         0x02
+
+void rpc_update(void);
+
+#endif // _RB2_RPC_H_
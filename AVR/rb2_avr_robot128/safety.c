@@ -0,0 +1,169 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Safety checks that cut the motors as soon as a fault is seen rather
+    than on the next motor update.  The tilt is checked as each IMU
+    sample arrives and the IMU and encoder data ages are checked at the
+    start of every control tick.  The motors stay cut while any fault
+    remains and are released again once the data is fresh and the pitch
+    is back within the limit.
+*/
+
+#include <stdint.h>
+#include "avrx.h"
+#include "blackbox.h"
+#include "motor.h"
+#include "safety.h"
+
+// Note: Assuming globals are zeroed.
+static uint8_t safety_trips;
+static uint8_t safety_imu_age;
+static uint8_t safety_encoder_age;
+static uint16_t safety_trip_count;
+
+// Task control.
+AVRX_MUTEX(safety_mutex);
+
+static void safety_trip(uint8_t reason)
+// Add the reason to the faults and cut the motors on a new trip.
+{
+    uint8_t tripped;
+
+    // Get exclusive access to the safety values.
+    AvrXWaitSemaphore(&safety_mutex);
+
+    // Note whether the motors are already cut and add the reason.
+    tripped = safety_trips;
+    safety_trips |= reason;
+
+    // Count the new trips.
+    if (!tripped && (safety_trip_count < 0xffff)) ++safety_trip_count;
+
+    // Release exclusive access to the safety values.
+    AvrXSetSemaphore(&safety_mutex);
+
+    // Cut the motors right away on a new trip.
+    if (!tripped) motor_stop();
+
+    // Freeze the blackbox on a fall.
+    if (reason & SAFETY_TILT) blackbox_trigger(BLACKBOX_FALL);
+}
+
+
+static void safety_clear(uint8_t reason)
+// Remove the reason from the faults.
+{
+    // Get exclusive access to the safety values.
+    AvrXWaitSemaphore(&safety_mutex);
+
+    // Clear the reason.
+    safety_trips &= ~reason;
+
+    // Release exclusive access to the safety values.
+    AvrXSetSemaphore(&safety_mutex);
+}
+
+
+void safety_init(void)
+// Initialize the safety checks.
+{
+    // Prime the safety mutex.
+    AvrXSetSemaphore(&safety_mutex);
+}
+
+
+void safety_update(void)
+// Age the IMU and encoder data.  This should be called at the start of
+// every control tick.
+{
+    // Age the data.
+    if (safety_imu_age < 0xff) ++safety_imu_age;
+    if (safety_encoder_age < 0xff) ++safety_encoder_age;
+
+    // Trip if either has not been refreshed within the deadline.
+    if (safety_imu_age > SAFETY_STALE_TICKS) safety_trip(SAFETY_IMU_STALE);
+    if (safety_encoder_age > SAFETY_STALE_TICKS) safety_trip(SAFETY_ENCODER_STALE);
+}
+
+
+void safety_imu_sample(int16_t pitch_angle)
+// Check the pitch angle of a new IMU sample.  This should be called as
+// soon as the sample arrives and while the USART is not held.
+{
+    // The IMU data is fresh.
+    safety_imu_age = 0;
+    safety_clear(SAFETY_IMU_STALE);
+
+    // Check the tilt limits.
+    if ((pitch_angle >= SAFETY_PITCH_LIMIT) || (pitch_angle <= -SAFETY_PITCH_LIMIT))
+        safety_trip(SAFETY_TILT);
+    else
+        safety_clear(SAFETY_TILT);
+}
+
+
+void safety_encoder_sample(void)
+// Note the arrival of new encoder counts.
+{
+    // The encoder data is fresh.
+    safety_encoder_age = 0;
+    safety_clear(SAFETY_ENCODER_STALE);
+}
+
+
+uint8_t safety_trips_get(void)
+// Get the current fault reasons.  Zero means the motors may run.
+{
+    uint8_t trips;
+
+    // Get exclusive access to the safety values.
+    AvrXWaitSemaphore(&safety_mutex);
+
+    // Get the faults.
+    trips = safety_trips;
+
+    // Release exclusive access to the safety values.
+    AvrXSetSemaphore(&safety_mutex);
+
+    return trips;
+}
+
+
+uint16_t safety_trip_count_get(void)
+// Get the number of times the motors were cut.
+{
+    uint16_t count;
+
+    // Get exclusive access to the safety values.
+    AvrXWaitSemaphore(&safety_mutex);
+
+    // Get the count.
+    count = safety_trip_count;
+
+    // Release exclusive access to the safety values.
+    AvrXSetSemaphore(&safety_mutex);
+
+    return count;
+}
@@ -0,0 +1,52 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_SAFETY_H_
+#define _RB2_SAFETY_H_ 1
+
+#include <stdint.h>
+#include "config.h"
+
+// The pitch beyond which the robot is considered fallen in 8:8 fixed
+// point degrees.
+#define SAFETY_PITCH_LIMIT      5120
+
+// The age in control ticks beyond which the IMU or encoder data is stale.
+#define SAFETY_STALE_TICKS      (30 / CONTROL_PERIOD)
+
+// Reasons the motors were cut.
+#define SAFETY_TILT             0x01
+#define SAFETY_IMU_STALE        0x02
+#define SAFETY_ENCODER_STALE    0x04
+
+void safety_init(void);
+void safety_update(void);
+void safety_imu_sample(int16_t pitch_angle);
+void safety_encoder_sample(void);
+uint8_t safety_trips_get(void);
+uint16_t safety_trip_count_get(void);
+
+#endif // _RB2_SAFETY_H_
@@ -0,0 +1,150 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Multi-rate scheduling of the control loop jobs.  Each job is declared
+    in a table with a period and phase in control ticks.  Jobs with longer
+    periods are given different phases so their bus and CPU load is spread
+    across ticks rather than piling up on the same tick.  The worst case
+    load of each tick is derived from the profiled maximum times of the
+    jobs that run in the tick.
+*/
+
+#include <stdint.h>
+#include <avr/pgmspace.h>
+#include "avrx.h"
+#include "profile.h"
+#include "sched.h"
+
+// Note: Assuming globals are zeroed.
+static uint8_t sched_slot;
+static uint8_t sched_count;
+static const sched_job *sched_jobs;
+
+void sched_init(const sched_job *jobs, uint8_t count)
+// Initialize the scheduler with the table of jobs in program memory.
+{
+    // Save the job table.
+    sched_jobs = jobs;
+    sched_count = count;
+
+    // Start with the first slot.
+    sched_slot = 0;
+}
+
+
+static uint8_t sched_job_due(const sched_job *job, uint8_t slot)
+// Determine if the job runs in the indicated slot.
+{
+    uint8_t period;
+    uint8_t phase;
+
+    // Get the job period and phase from program memory.
+    period = pgm_read_byte(&job->period);
+    phase = pgm_read_byte(&job->phase);
+
+    return (slot & (period - 1)) == phase ? 1 : 0;
+}
+
+
+void sched_run(void)
+// Run the jobs due in the current slot and advance to the next slot.
+{
+    uint8_t i;
+    uint16_t start;
+    void (*func)(void);
+    const sched_job *job;
+
+    // Mark the start of the first job.
+    start = profile_time();
+
+    // Run each job due in this slot in table order.
+    for (i = 0, job = sched_jobs; i < sched_count; ++i, ++job)
+    {
+        if (sched_job_due(job, sched_slot))
+        {
+            // Run the job.
+            func = (void (*)(void)) pgm_read_word(&job->func);
+            func();
+
+            // Account the job time to its profile stage.
+            start = profile_stop(pgm_read_byte(&job->stage), start);
+        }
+    }
+
+    // Advance to the next slot.
+    sched_slot = (sched_slot + 1) & (SCHED_SLOTS - 1);
+}
+
+
+uint16_t sched_load_get(uint8_t slot)
+// Get the worst case load of the slot in profile timer ticks.  This is
+// the sum of the maximum profiled times of the jobs due in the slot.
+{
+    uint8_t i;
+    uint16_t load;
+    profile_stats stats;
+    const sched_job *job;
+
+    // Sum the maximum times of the jobs due in the slot.
+    for (i = 0, load = 0, job = sched_jobs; i < sched_count; ++i, ++job)
+    {
+        if (sched_job_due(job, slot))
+        {
+            // Get the job statistics.
+            profile_stats_get(pgm_read_byte(&job->stage), &stats);
+
+            // Add to the load.
+            load += stats.max;
+        }
+    }
+
+    return load;
+}
+
+
+uint8_t sched_worst_get(uint16_t *load)
+// Get the slot with the worst case load along with the load.
+{
+    uint8_t slot;
+    uint8_t worst_slot;
+    uint16_t slot_load;
+    uint16_t worst_load;
+
+    // Find the slot with the highest load.
+    for (slot = 0, worst_slot = 0, worst_load = 0; slot < SCHED_SLOTS; ++slot)
+    {
+        slot_load = sched_load_get(slot);
+        if (slot_load > worst_load)
+        {
+            worst_slot = slot;
+            worst_load = slot_load;
+        }
+    }
+
+    // Return the load.
+    if (load) *load = worst_load;
+
+    return worst_slot;
+}
@@ -0,0 +1,56 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_SCHED_H_
+#define _RB2_SCHED_H_ 1
+
+#include <stdint.h>
+
+// Number of control ticks in the schedule.  The period of each job must
+// be a power of two that evenly divides the number of slots.
+#define SCHED_SLOTS             32
+
+// Check a job period and phase at compile time.  The period must be a
+// power of two no longer than the schedule and the phase must be less
+// than the period or the job never runs.
+#define SCHED_JOB_VALID(period, phase) \
+    ((period) > 0 && ((period) & ((period) - 1)) == 0 && \
+     (period) <= SCHED_SLOTS && (phase) < (period))
+
+typedef struct
+{
+    void (*func)(void);
+    uint8_t period;
+    uint8_t phase;
+    uint8_t stage;
+} sched_job;
+
+void sched_init(const sched_job *jobs, uint8_t count);
+void sched_run(void);
+uint16_t sched_load_get(uint8_t slot);
+uint8_t sched_worst_get(uint16_t *load);
+
+#endif // _RB2_SCHED_H_
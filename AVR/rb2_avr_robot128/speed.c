@@ -28,6 +28,7 @@
 #include <stdio.h>
 #include "avrx.h"
 #include "balance.h"
+#include "config.h"
 #include "encoder.h"
 #include "uio.h"
 #include "motor.h"
@@ -60,21 +61,33 @@ void speed_init(void)
 
 
 void speed_update(void)
-// Main speed control loop.
+// Main speed control loop.  The RC value only changes with a new receiver
+// frame so the filter is skipped once it has settled on the last frame.
 {
-    int8_t speed_rc;
-    int16_t tilt;
+    uint8_t sequence;
+    int16_t speed_rc;
+    int16_t tilt_rc;
+    static int16_t tilt;
+    static uint8_t tilt_settled;
+    static uint8_t last_sequence;
     static int32_t tilt_filter;
 
-    // Get the RC control values.
-    uio_get_rc(NULL, &speed_rc);
+    // Get the full resolution RC control values.
+    sequence = uio_get_rc_wide(NULL, &speed_rc, NULL);
 
-    // Convert the RC value to a tilt value.
-    tilt = ((int16_t) speed_rc * 6);
+    if ((sequence != last_sequence) || !tilt_settled)
+    {
+        // Convert the RC value to a tilt value.
+        tilt_rc = (speed_rc * 3) / 4;
 
-    // Pass the speed through a low pass filter to prevent wild swings.
-    tilt_filter = tilt_filter - (tilt_filter >> 3) + tilt;
-    tilt = (int16_t) (tilt_filter >> 3);
+        // Pass the speed through a low pass filter to prevent wild swings.
+        tilt_filter = tilt_filter - (tilt_filter >> CONTROL_FILTER_SHIFT) + tilt_rc;
+        tilt = (int16_t) (tilt_filter >> CONTROL_FILTER_SHIFT);
+
+        // The filter no longer changes once its output reaches its input.
+        tilt_settled = (tilt == tilt_rc) ? 1 : 0;
+        last_sequence = sequence;
+    }
 
     // Set the tilt which is the output of the this control loop.
     balance_tilt_set(tilt);
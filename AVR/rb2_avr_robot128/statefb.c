@@ -0,0 +1,78 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Full state feedback controller.  The pitch angle, pitch rate, wheel
+    position and wheel velocity errors are combined with a single gain
+    vector product each control period.  The motors are velocity
+    controlled so the product is treated as the wheel acceleration and
+    is integrated into the velocity command.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "avrx.h"
+#include "fixed.h"
+#include "statefb.h"
+
+void statefb_init(statefb *self)
+{
+    // Zero out the statefb structure.
+    memset(self, 0, sizeof(statefb));
+}
+
+int16_t statefb_get_output(statefb *self, const int16_t *state)
+// Determine the velocity output from the state vector.  The gains are 8:8
+// fixed point values and the output is held with 8 bits of fraction in the
+// accumulator the same as the ipd integral.
+{
+    int32_t product;
+    int32_t output;
+
+    // Multiply the state vector by the gain vector.
+    product = fixed_mul16(state[STATEFB_ANGLE], self->gain[STATEFB_ANGLE]);
+    product = fixed_mac16(product, state[STATEFB_RATE], self->gain[STATEFB_RATE]);
+    product = fixed_mac16(product, state[STATEFB_POSITION], self->gain[STATEFB_POSITION]);
+    product = fixed_mac16(product, state[STATEFB_VELOCITY], self->gain[STATEFB_VELOCITY]);
+
+    // Integrate the acceleration into the velocity output.
+    self->output = fixed_add32(self->output, product);
+
+    // Get the upper 24 bits of the output.
+    output = self->output >> 8;
+
+    // Limit the output and hold the accumulator at the saturation level.
+    if (output > self->max_output)
+    {
+        output = self->max_output;
+        self->output = output << 8;
+    }
+    else if (output < -self->max_output)
+    {
+        output = -self->max_output;
+        self->output = output << 8;
+    }
+
+    return (int16_t) output;
+}
@@ -0,0 +1,54 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_STATEFB_H_
+#define _RB2_STATEFB_H_ 1
+
+// State vector elements.
+#define STATEFB_ANGLE           0
+#define STATEFB_RATE            1
+#define STATEFB_POSITION        2
+#define STATEFB_VELOCITY        3
+#define STATEFB_STATES          4
+
+typedef struct
+{
+    int16_t gain[STATEFB_STATES];
+    int16_t max_output;
+    int32_t output;
+} statefb;
+
+inline static int16_t statefb_get_gain(statefb *self, uint8_t state) { return self->gain[state]; }
+inline static int16_t statefb_get_max_output(statefb *self) { return self->max_output; }
+
+inline static void statefb_set_gain(statefb *self, uint8_t state, int16_t gain) { self->gain[state] = gain; }
+inline static void statefb_set_max_output(statefb *self, int16_t max_output) { self->max_output = max_output; }
+inline static void statefb_reset(statefb *self) { self->output = 0; }
+
+void statefb_init(statefb *self);
+int16_t statefb_get_output(statefb *self, const int16_t *state);
+
+#endif // _RB2_STATEFB_H_
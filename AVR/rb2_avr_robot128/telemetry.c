@@ -0,0 +1,277 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Binary telemetry stream on USART0.  Frames are copied into a transmit
+    ring buffer and drained by the data register empty interrupt so the
+    control task never waits on the serial line.  A frame that does not
+    fit in the buffer is dropped whole rather than blocking the caller.
+    Received bytes are buffered by the receive interrupt and polled.
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/crc16.h>
+#include "avrx.h"
+#include "balance.h"
+#include "blackbox.h"
+#include "config.h"
+#include "encoder.h"
+#include "imu.h"
+#include "mirror.h"
+#include "motor.h"
+#include "telemetry.h"
+
+#if (CPUCLK == 8000000)
+#define BAUD2UBRR_250K      3
+#endif
+
+#if (CPUCLK == 16000000)
+#define BAUD2UBRR_250K      7
+#endif
+
+#if (CPUCLK == 20000000)
+#define BAUD2UBRR_250K      9
+#endif
+
+// Transmit buffer size.  Must be a power of two no larger than 256.  At
+// 250K baud the buffer drains in about 5 milliseconds.  The bus mirror
+// uses the largest buffer so it can fill the link for a whole 10
+// millisecond tick.
+#if BUS_MIRROR
+#define TELEMETRY_BUFFER_SIZE   256
+#else
+#define TELEMETRY_BUFFER_SIZE   128
+#endif
+#define TELEMETRY_BUFFER_MASK   (TELEMETRY_BUFFER_SIZE - 1)
+
+// Receive buffer size.  Must be a power of two no larger than 256 and
+// large enough to hold the largest parameter request.
+#define TELEMETRY_RX_SIZE       64
+#define TELEMETRY_RX_MASK       (TELEMETRY_RX_SIZE - 1)
+
+// Note: Assuming globals are zeroed.
+
+// Transmit ring buffer.  The head is only written by the sender and the
+// tail only by the interrupt so single byte indices need no locking.
+static uint8_t telemetry_buffer[TELEMETRY_BUFFER_SIZE];
+static volatile uint8_t telemetry_head;
+static volatile uint8_t telemetry_tail;
+
+// Receive ring buffer.  The head is only written by the interrupt and
+// the tail only by the reader.
+static uint8_t telemetry_rx_buffer[TELEMETRY_RX_SIZE];
+static volatile uint8_t telemetry_rx_head;
+static volatile uint8_t telemetry_rx_tail;
+
+// Frame sequences and dropped frame count.
+static uint16_t telemetry_sequence[TELEMETRY_FRAME_TYPES];
+static uint16_t telemetry_drops;
+
+
+ISR(USART0_UDRE_vect)
+// Send the next buffered byte or stop when the buffer is empty.  This is a
+// plain interrupt as it never signals an AvrX task.
+{
+    uint8_t tail = telemetry_tail;
+
+    if (tail != telemetry_head)
+    {
+        UDR0 = telemetry_buffer[tail];
+        telemetry_tail = (tail + 1) & TELEMETRY_BUFFER_MASK;
+    }
+    else
+    {
+        // Disable the data register empty interrupt.
+        UCSR0B &= ~(1<<UDRIE0);
+    }
+}
+
+
+ISR(USART0_RX_vect)
+// Buffer the received byte.  The byte is lost if the buffer is full.
+{
+    uint8_t data = UDR0;
+    uint8_t head = telemetry_rx_head;
+    uint8_t next = (head + 1) & TELEMETRY_RX_MASK;
+
+    if (next != telemetry_rx_tail)
+    {
+        telemetry_rx_buffer[head] = data;
+        telemetry_rx_head = next;
+    }
+}
+
+
+void telemetry_init(void)
+// Initialize USART0 for 8 bit frames at 250K baud.
+{
+    // Set the baud rate.
+    UBRR0H = BAUD2UBRR_250K >> 8;
+    UBRR0L = BAUD2UBRR_250K & 0xff;
+
+    // Set transfer rate doubler.
+    UCSR0A = (1<<U2X0);
+
+    // Enable the receive interrupt, receiver and transmitter.  The data
+    // register empty interrupt is enabled as frames are queued.
+    UCSR0B = (1<<RXCIE0) | (1<<RXEN0) | (1<<TXEN0);
+
+    // Set frame format: Asynchronous, 8 data, 1 stop bit, no parity.
+    UCSR0C = (0<<UMSEL0) |                      // Asynchronous UART.
+             (0<<UPM01) | (0<<UPM00) |          // Parity disabled.
+             (0<<USBS0) |                       // One stop bit.
+             (1<<UCSZ01) | (1<<UCSZ00);         // 8-bit size.
+}
+
+
+uint8_t telemetry_frame_send(uint8_t type, const void *payload, uint8_t length)
+// Queue a frame for transmission.  Returns 1 if the frame was queued or
+// 0 if it was dropped because the buffer lacked room.
+{
+    uint8_t i;
+    uint8_t head;
+    uint8_t data;
+    uint16_t crc;
+    uint16_t sequence;
+    const uint8_t *bytes = (const uint8_t *) payload;
+
+    // Each frame consumes a sequence number even if it is dropped.
+    sequence = ++telemetry_sequence[type];
+
+    // Drop the whole frame if it does not fit.  One slot is always left
+    // open to tell a full buffer from an empty one.
+    if (telemetry_room_get() < (length + TELEMETRY_FRAME_OVERHEAD))
+    {
+        if (telemetry_drops < 0xffff) ++telemetry_drops;
+        return 0;
+    }
+
+    head = telemetry_head;
+
+    // Sync bytes.
+    telemetry_buffer[head] = TELEMETRY_SYNC1;
+    head = (head + 1) & TELEMETRY_BUFFER_MASK;
+    telemetry_buffer[head] = TELEMETRY_SYNC2;
+    head = (head + 1) & TELEMETRY_BUFFER_MASK;
+
+    // Type, length, sequence and payload covered by the crc.
+    crc = 0xffff;
+    for (i = 0; i < length + 4; ++i)
+    {
+        if (i == 0) data = type;
+        else if (i == 1) data = length;
+        else if (i == 2) data = sequence & 0xff;
+        else if (i == 3) data = sequence >> 8;
+        else data = bytes[i - 4];
+
+        crc = _crc_ccitt_update(crc, data);
+        telemetry_buffer[head] = data;
+        head = (head + 1) & TELEMETRY_BUFFER_MASK;
+    }
+
+    // Crc.
+    telemetry_buffer[head] = crc & 0xff;
+    head = (head + 1) & TELEMETRY_BUFFER_MASK;
+    telemetry_buffer[head] = crc >> 8;
+    head = (head + 1) & TELEMETRY_BUFFER_MASK;
+
+    // Publish the frame and make sure the interrupt is draining the buffer.
+    telemetry_head = head;
+    UCSR0B |= (1<<UDRIE0);
+
+    return 1;
+}
+
+
+void telemetry_update(void)
+// Send the control frame for this tick.  The same state is written to the
+// blackbox and any frozen blackbox is sent a part at a time.  The bus
+// mirror replaces the control frames and gets what room is left.
+{
+    static telemetry_control frame;
+
+    // Gather the state of the control loop.
+    imu_pitch_get(&frame.pitch_angle, &frame.pitch_rate);
+    frame.tilt = balance_tilt_get();
+    encoder_get_deltas(&frame.left_delta, &frame.right_delta);
+    motor_pwm_get(&frame.left_pwm, &frame.right_pwm);
+
+#if !BUS_MIRROR
+    // Queue the frame.
+    telemetry_frame_send(TELEMETRY_FRAME_CONTROL, &frame, sizeof(frame));
+#endif
+
+    // Record the tick in the blackbox.
+    blackbox_write(frame.pitch_angle, frame.pitch_rate, frame.tilt, frame.left_pwm, frame.right_pwm);
+
+    // Send the next part of a frozen blackbox.
+    blackbox_dump_next();
+
+#if BUS_MIRROR
+    // Send the mirrored bus words.
+    mirror_update();
+#endif
+}
+
+
+uint8_t telemetry_recv(uint8_t *data)
+// Get the next received byte.  Returns 0 if no byte is waiting.
+{
+    uint8_t tail = telemetry_rx_tail;
+
+    if (tail == telemetry_rx_head) return 0;
+
+    *data = telemetry_rx_buffer[tail];
+    telemetry_rx_tail = (tail + 1) & TELEMETRY_RX_MASK;
+
+    return 1;
+}
+
+
+uint8_t telemetry_room_get(void)
+// Get the number of bytes that can be queued.  The room only grows until
+// the next frame is queued.
+{
+    return (telemetry_tail - telemetry_head - 1) & TELEMETRY_BUFFER_MASK;
+}
+
+
+uint16_t telemetry_drops_get(void)
+// Get the number of frames dropped because the buffer was full.
+{
+    uint16_t drops;
+
+    // Disable interrupts while the drops are read.
+    cli();
+
+    // Get the drops.
+    drops = telemetry_drops;
+
+    // Enable interrupts.
+    sei();
+
+    return drops;
+}
@@ -0,0 +1,68 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_TELEMETRY_H_
+#define _RB2_TELEMETRY_H_ 1
+
+// Telemetry frame layout.  Multi-byte values are little endian.
+//
+//   sync1 sync2 type length seq_lo seq_hi payload[length] crc_lo crc_hi
+//
+// Each frame type has its own sequence which increments for every frame
+// including those dropped when the transmit buffer is full so gaps are
+// visible to the receiver.  The CRC is the avr-libc CCITT CRC-16 seeded
+// with 0xffff and run over the type, length, sequence and payload bytes.
+#define TELEMETRY_SYNC1             0xA5
+#define TELEMETRY_SYNC2             0x5A
+#define TELEMETRY_FRAME_OVERHEAD    8
+
+// Telemetry frame types.
+#define TELEMETRY_FRAME_CONTROL     0x01
+#define TELEMETRY_FRAME_BLACKBOX    0x02
+#define TELEMETRY_FRAME_PARAM       0x03
+#define TELEMETRY_FRAME_BUS         0x04
+#define TELEMETRY_FRAME_TYPES       5
+
+// Control frame payload sent every control tick.
+typedef struct
+{
+    int16_t pitch_angle;
+    int16_t pitch_rate;
+    int16_t tilt;
+    int16_t left_delta;
+    int16_t right_delta;
+    int8_t left_pwm;
+    int8_t right_pwm;
+} telemetry_control;
+
+void telemetry_init(void);
+void telemetry_update(void);
+uint8_t telemetry_frame_send(uint8_t type, const void *payload, uint8_t length);
+uint8_t telemetry_room_get(void);
+uint16_t telemetry_drops_get(void);
+uint8_t telemetry_recv(uint8_t *data);
+
+#endif // _RB2_TELEMETRY_H_
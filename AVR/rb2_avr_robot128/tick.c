@@ -0,0 +1,187 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Hardware timed control tick.  Timer/counter1 runs in CTC mode and the
+    compare match interrupt releases the control task every control period
+    independent of when the task last ran.  The timer count when the task
+    wakes is the latency from the compare match which is accumulated into
+    jitter statistics.
+*/
+
+#include <stdint.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "avrx.h"
+#include "tick.h"
+
+// Number of samples averaged into the mean latency.
+#define TICK_WINDOW         64
+
+// Task control.
+AVRX_MUTEX(tick_ready);
+
+// Note: Assuming globals are zeroed.
+static volatile uint8_t tick_pending;
+static uint16_t tick_overruns;
+static uint16_t tick_min;
+static uint16_t tick_max;
+static uint16_t tick_mean;
+static uint16_t tick_count;
+static uint32_t tick_sum;
+static uint8_t tick_window;
+
+void tick_reset(void)
+// Reset the jitter statistics.
+{
+    // Disable interrupts while the statistics are reset.
+    cli();
+
+    // Reset the statistics.
+    tick_min = 0xffff;
+    tick_max = 0;
+    tick_mean = 0;
+    tick_count = 0;
+    tick_sum = 0;
+    tick_window = 0;
+    tick_overruns = 0;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void tick_init(void)
+// Initialize the tick timer.  The first tick is released one control
+// period after this call.
+{
+    // Reset the statistics.
+    tick_reset();
+
+    // Initialize timer/counter1 in CTC mode at clk/8.
+    TCNT1 = 0;
+    OCR1A = TICK_COUNTS - 1;
+    TCCR1A = (0<<COM1A1) | (0<<COM1A0) |                        // Disconnect OC1A.
+             (0<<COM1B1) | (0<<COM1B0) |                        // Disconnect OC1B.
+             (0<<COM1C1) | (0<<COM1C0) |                        // Disconnect OC1C.
+             (0<<WGM11) | (0<<WGM10);                           // Mode 4 - CTC on OCR1A.
+    TCCR1B = (0<<ICNC1) | (0<<ICES1) |                          // No input capture.
+             (0<<WGM13) | (1<<WGM12) |                          // Mode 4 - CTC on OCR1A.
+             (0<<CS12) | (1<<CS11) | (0<<CS10);                 // Clk/8.
+    TIFR = (1<<OCF1A);                                          // Clear pending compare.
+    TIMSK |= (1<<OCIE1A);                                       // Interrupt on output compare.
+}
+
+
+void tick_wait(void)
+// Wait for the next control tick and account the wake up latency.
+{
+    uint16_t latency;
+
+    // Wait for the compare match to release us.
+    AvrXWaitSemaphore(&tick_ready);
+
+    // The timer count is the time since the compare match.
+    latency = TCNT1;
+
+    // Disable interrupts while the statistics are updated.
+    cli();
+
+    // More than one pending tick means the previous loop overran the period.
+    if ((tick_pending > 1) && (tick_overruns < 0xffff)) ++tick_overruns;
+    tick_pending = 0;
+
+    // Update the minimum and maximum latency.
+    if (latency < tick_min) tick_min = latency;
+    if (latency > tick_max) tick_max = latency;
+
+    // Accumulate the latency until the window is full and then update the mean.
+    tick_sum += latency;
+    if (++tick_window == TICK_WINDOW)
+    {
+        tick_mean = (uint16_t) (tick_sum / TICK_WINDOW);
+        tick_sum = 0;
+        tick_window = 0;
+    }
+
+    // Count the samples.
+    if (tick_count < 0xffff) ++tick_count;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+void tick_stats_get(profile_stats *stats)
+// Get the wake up latency statistics in timer ticks.  The jitter
+// is the difference between the maximum and minimum latency.
+{
+    // Disable interrupts while the statistics are copied.
+    cli();
+
+    // Copy the statistics.
+    stats->min = tick_count ? tick_min : 0;
+    stats->max = tick_max;
+    stats->mean = tick_mean;
+    stats->count = tick_count;
+
+    // Enable interrupts.
+    sei();
+}
+
+
+uint16_t tick_overruns_get(void)
+// Get the number of control ticks released before the previous
+// tick was finished.
+{
+    uint16_t overruns;
+
+    // Disable interrupts while the overruns are read.
+    cli();
+
+    // Get the overruns.
+    overruns = tick_overruns;
+
+    // Enable interrupts.
+    sei();
+
+    return overruns;
+}
+
+
+AVRX_SIGINT(TIMER1_COMPA_vect)
+// Control tick compare match interrupt handler.
+{
+    // Switch to kernel stack.
+    IntProlog();
+
+    // Count the pending ticks.
+    if (tick_pending < 0xff) ++tick_pending;
+
+    // Release the control task.
+    AvrXSetSemaphore(&tick_ready);
+
+    // Go back to RTOS.
+    Epilog();
+}
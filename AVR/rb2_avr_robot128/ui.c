@@ -31,12 +31,20 @@
 #include <avr/pgmspace.h>
 #include "avrx.h"
 #include "balance.h"
+#include "bench.h"
+#include "blackbox.h"
 #include "bootloader.h"
 #include "control.h"
+#include "gainsched.h"
 #include "motor.h"
+#include "odometry.h"
 #include "imu.h"
 #include "lcd.h"
+#include "profile.h"
+#include "sched.h"
 #include "speed.h"
+#include "statefb.h"
+#include "tick.h"
 #include "ui.h"
 #include "uio.h"
 
@@ -69,12 +77,22 @@ static uint8_t ui_balance_p_gain(uint8_t input);
 static uint8_t ui_balance_d_gain(uint8_t input);
 static uint8_t ui_balance_i_gain(uint8_t input);
 static uint8_t ui_balance_t_comp(uint8_t input);
+static uint8_t ui_balance_mode(uint8_t input);
+static uint8_t ui_balance_sf_gains(uint8_t input);
+static uint8_t ui_balance_schedule(uint8_t input);
 static uint8_t ui_speed_p_gain(uint8_t input);
 static uint8_t ui_speed_d_gain(uint8_t input);
 static uint8_t ui_speed_i_gain(uint8_t input);
 static uint8_t ui_control_rc(uint8_t input);
+static uint8_t ui_control_pose(uint8_t input);
+static uint8_t ui_control_blackbox(uint8_t input);
 static uint8_t ui_imu_pitch(uint8_t input);
 static uint8_t ui_imu_raw(uint8_t input);
+static uint8_t ui_profile_stages(uint8_t input);
+static uint8_t ui_profile_deadline(uint8_t input);
+static uint8_t ui_profile_load(uint8_t input);
+static uint8_t ui_profile_jitter(uint8_t input);
+static uint8_t ui_profile_bench(uint8_t input);
 static uint8_t ui_boot_enable(uint8_t input);
 
 const char MT_TOP[] PROGMEM                         = "\x0c" "Balance 'Bot";
@@ -92,6 +110,12 @@ const char MT_BALANCE_P_GAIN[] PROGMEM              = "\x0c" "P Gain";
 const char MT_BALANCE_D_GAIN[] PROGMEM              = "\x0c" "D Gain";
 const char MT_BALANCE_I_GAIN[] PROGMEM              = "\x0c" "I Gain";
 const char MT_BALANCE_T_COMP[] PROGMEM              = "\x0c" "T Comp";
+const char MT_BALANCE_MODE[] PROGMEM                = "\x0c" "Controller";
+const char MT_BALANCE_SF_GAINS[] PROGMEM            = "\x0c" "State Fb Gains";
+const char MT_BALANCE_SCHEDULE[] PROGMEM            = "\x0c" "Gain Schedule";
+
+// Angle, rate, position and velocity gain names.
+const char ui_sf_gain_names[STATEFB_STATES] PROGMEM = { 'A', 'R', 'P', 'V' };
 
 const char MT_SPEED_MENU[] PROGMEM                  = "\x0c" "Speed";
 const char MT_SPEED_P_GAIN[] PROGMEM                = "\x0c" "P Gain";
@@ -100,11 +124,91 @@ const char MT_SPEED_I_GAIN[] PROGMEM                = "\x0c" "I Gain";
 
 const char MT_CONTROL_MENU[] PROGMEM                = "\x0c" "Control";
 const char MT_CONTROL_RC[] PROGMEM                  = "\x0c" "RC Values";
+const char MT_CONTROL_POSE[] PROGMEM                = "\x0c" "Pose mm Deg";
+const char MT_CONTROL_BLACKBOX[] PROGMEM            = "\x0c" "Black Box";
+
+const char MT_BLACKBOX_RUNNING[] PROGMEM            = "Running";
+const char MT_BLACKBOX_FALL[] PROGMEM               = "Fall";
+const char MT_BLACKBOX_WATCHDOG[] PROGMEM           = "Watchdog";
+const char MT_BLACKBOX_USER[] PROGMEM               = "User";
+
+PGM_P const ui_blackbox_text[] PROGMEM =
+{
+    MT_BLACKBOX_RUNNING,
+    MT_BLACKBOX_FALL,
+    MT_BLACKBOX_WATCHDOG,
+    MT_BLACKBOX_USER
+};
 
 const char MT_IMU_MENU[] PROGMEM                    = "\x0c" "IMU";
 const char MT_IMU_PITCH[] PROGMEM                   = "\x0c" "Pitch & Rate";
 const char MT_IMU_RAW[] PROGMEM                     = "\x0c" "Raw Values";
 
+const char MT_PROFILE_MENU[] PROGMEM                = "\x0c" "Profile";
+const char MT_PROFILE_STAGES[] PROGMEM              = "\x0c" "Stage Times";
+const char MT_PROFILE_DEADLINE[] PROGMEM            = "\x0c" "Deadline";
+const char MT_PROFILE_LOAD[] PROGMEM                = "\x0c" "Tick Load uS";
+const char MT_PROFILE_JITTER[] PROGMEM              = "\x0c" "Tick Jitter uS";
+const char MT_PROFILE_BENCH[] PROGMEM               = "\x0c" "Math Cycles";
+
+const char MT_PROFILE_ENCODER[] PROGMEM             = "\x0c" "Encoder uS";
+const char MT_PROFILE_SPEED[] PROGMEM               = "\x0c" "Speed uS";
+const char MT_PROFILE_BALANCE[] PROGMEM             = "\x0c" "Balance uS";
+const char MT_PROFILE_HEADING[] PROGMEM             = "\x0c" "Heading uS";
+const char MT_PROFILE_MOTOR[] PROGMEM               = "\x0c" "Motor uS";
+const char MT_PROFILE_UIO[] PROGMEM                 = "\x0c" "UIO uS";
+const char MT_PROFILE_LCD[] PROGMEM                 = "\x0c" "LCD uS";
+const char MT_PROFILE_LED[] PROGMEM                 = "\x0c" "LED uS";
+const char MT_PROFILE_ODOMETRY[] PROGMEM            = "\x0c" "Odometry uS";
+const char MT_PROFILE_SAFETY[] PROGMEM              = "\x0c" "Safety uS";
+const char MT_PROFILE_TELEMETRY[] PROGMEM           = "\x0c" "Telemetry uS";
+const char MT_PROFILE_RPC[] PROGMEM                 = "\x0c" "Param RPC uS";
+const char MT_PROFILE_LOOP[] PROGMEM                = "\x0c" "Loop uS";
+
+PGM_P const ui_profile_text[PROFILE_COUNT] PROGMEM =
+{
+    MT_PROFILE_ENCODER,
+    MT_PROFILE_SPEED,
+    MT_PROFILE_BALANCE,
+    MT_PROFILE_HEADING,
+    MT_PROFILE_MOTOR,
+    MT_PROFILE_UIO,
+    MT_PROFILE_LCD,
+    MT_PROFILE_LED,
+    MT_PROFILE_ODOMETRY,
+    MT_PROFILE_SAFETY,
+    MT_PROFILE_TELEMETRY,
+    MT_PROFILE_RPC,
+    MT_PROFILE_LOOP
+};
+
+const char MT_BENCH_MUL32[] PROGMEM                 = "\x0c" "32x32 Mul";
+const char MT_BENCH_MUL16[] PROGMEM                 = "\x0c" "16x16 Mul";
+const char MT_BENCH_FMUL15[] PROGMEM                = "\x0c" "Q1.15 Mul";
+const char MT_BENCH_MAC16[] PROGMEM                 = "\x0c" "Sat MAC";
+const char MT_BENCH_MUL_Q16[] PROGMEM               = "\x0c" "Q16.16 Mul";
+const char MT_BENCH_PID[] PROGMEM                   = "\x0c" "PID Kernel";
+const char MT_BENCH_PID_PAIR[] PROGMEM              = "\x0c" "PID Pair";
+const char MT_BENCH_PID2[] PROGMEM                  = "\x0c" "PID2 Kernel";
+const char MT_BENCH_IPD[] PROGMEM                   = "\x0c" "IPD Kernel";
+const char MT_BENCH_STATEFB[] PROGMEM               = "\x0c" "StateFb Kernel";
+const char MT_BENCH_GAINSCHED[] PROGMEM             = "\x0c" "Gain Sched";
+
+PGM_P const ui_bench_text[BENCH_COUNT] PROGMEM =
+{
+    MT_BENCH_MUL32,
+    MT_BENCH_MUL16,
+    MT_BENCH_FMUL15,
+    MT_BENCH_MAC16,
+    MT_BENCH_MUL_Q16,
+    MT_BENCH_PID,
+    MT_BENCH_PID_PAIR,
+    MT_BENCH_PID2,
+    MT_BENCH_IPD,
+    MT_BENCH_STATEFB,
+    MT_BENCH_GAINSCHED
+};
+
 
 const char MT_BOOT_MENU[] PROGMEM                 = "\x0c" "Bootloader";
 
@@ -134,11 +238,16 @@ const menu_state_next ui_menu_state_next[] PROGMEM =
     { ST_CONTROL_MENU,          BUTTON_RIGHT,   ST_CONTROL_RC },
 
     { ST_IMU_MENU,              BUTTON_UP,      ST_CONTROL_MENU },
-    { ST_IMU_MENU,              BUTTON_DOWN,    ST_BOOT_MENU },
+    { ST_IMU_MENU,              BUTTON_DOWN,    ST_PROFILE_MENU },
     { ST_IMU_MENU,              BUTTON_LEFT,    ST_TOP },
     { ST_IMU_MENU,              BUTTON_RIGHT,   ST_IMU_PITCH },
 
-    { ST_BOOT_MENU,             BUTTON_UP,      ST_IMU_MENU },
+    { ST_PROFILE_MENU,          BUTTON_UP,      ST_IMU_MENU },
+    { ST_PROFILE_MENU,          BUTTON_DOWN,    ST_BOOT_MENU },
+    { ST_PROFILE_MENU,          BUTTON_LEFT,    ST_TOP },
+    { ST_PROFILE_MENU,          BUTTON_RIGHT,   ST_PROFILE_STAGES },
+
+    { ST_BOOT_MENU,             BUTTON_UP,      ST_PROFILE_MENU },
     { ST_BOOT_MENU,             BUTTON_DOWN,    ST_MOTOR_MENU },
     { ST_BOOT_MENU,             BUTTON_LEFT,    ST_TOP },
     { ST_BOOT_MENU,             BUTTON_RIGHT,   ST_BOOT_ENABLE },
@@ -173,7 +282,7 @@ const menu_state_next ui_menu_state_next[] PROGMEM =
     { ST_MOTOR_I_GAIN,          BUTTON_LEFT,    ST_MOTOR_MENU },
     { ST_MOTOR_I_GAIN,          BUTTON_RIGHT,   ST_MOTOR_I_GAIN_SEL },
 
-    { ST_BALANCE_P_GAIN,        BUTTON_UP,      ST_BALANCE_T_COMP },
+    { ST_BALANCE_P_GAIN,        BUTTON_UP,      ST_BALANCE_SCHEDULE },
     { ST_BALANCE_P_GAIN,        BUTTON_DOWN,    ST_BALANCE_D_GAIN },
     { ST_BALANCE_P_GAIN,        BUTTON_LEFT,    ST_BALANCE_MENU },
     { ST_BALANCE_P_GAIN,        BUTTON_RIGHT,   ST_BALANCE_P_GAIN_SEL },
@@ -189,10 +298,25 @@ const menu_state_next ui_menu_state_next[] PROGMEM =
     { ST_BALANCE_I_GAIN,        BUTTON_RIGHT,   ST_BALANCE_I_GAIN_SEL },
 
     { ST_BALANCE_T_COMP,        BUTTON_UP,      ST_BALANCE_I_GAIN },
-    { ST_BALANCE_T_COMP,        BUTTON_DOWN,    ST_BALANCE_P_GAIN },
+    { ST_BALANCE_T_COMP,        BUTTON_DOWN,    ST_BALANCE_MODE },
     { ST_BALANCE_T_COMP,        BUTTON_LEFT,    ST_BALANCE_MENU },
     { ST_BALANCE_T_COMP,        BUTTON_RIGHT,   ST_BALANCE_T_COMP_SEL },
 
+    { ST_BALANCE_MODE,          BUTTON_UP,      ST_BALANCE_T_COMP },
+    { ST_BALANCE_MODE,          BUTTON_DOWN,    ST_BALANCE_SF_GAINS },
+    { ST_BALANCE_MODE,          BUTTON_LEFT,    ST_BALANCE_MENU },
+    { ST_BALANCE_MODE,          BUTTON_RIGHT,   ST_BALANCE_MODE_SEL },
+
+    { ST_BALANCE_SF_GAINS,      BUTTON_UP,      ST_BALANCE_MODE },
+    { ST_BALANCE_SF_GAINS,      BUTTON_DOWN,    ST_BALANCE_SCHEDULE },
+    { ST_BALANCE_SF_GAINS,      BUTTON_LEFT,    ST_BALANCE_MENU },
+    { ST_BALANCE_SF_GAINS,      BUTTON_RIGHT,   ST_BALANCE_SF_GAINS_SEL },
+
+    { ST_BALANCE_SCHEDULE,      BUTTON_UP,      ST_BALANCE_SF_GAINS },
+    { ST_BALANCE_SCHEDULE,      BUTTON_DOWN,    ST_BALANCE_P_GAIN },
+    { ST_BALANCE_SCHEDULE,      BUTTON_LEFT,    ST_BALANCE_MENU },
+    { ST_BALANCE_SCHEDULE,      BUTTON_RIGHT,   ST_BALANCE_SCHEDULE_SEL },
+
     { ST_SPEED_P_GAIN,          BUTTON_UP,      ST_SPEED_I_GAIN },
     { ST_SPEED_P_GAIN,          BUTTON_DOWN,    ST_SPEED_D_GAIN },
     { ST_SPEED_P_GAIN,          BUTTON_LEFT,    ST_SPEED_MENU },
@@ -208,11 +332,21 @@ const menu_state_next ui_menu_state_next[] PROGMEM =
     { ST_SPEED_I_GAIN,          BUTTON_LEFT,    ST_SPEED_MENU },
     { ST_SPEED_I_GAIN,          BUTTON_RIGHT,   ST_SPEED_I_GAIN_SEL },
 
-    { ST_CONTROL_RC,            BUTTON_UP,      ST_CONTROL_RC },
-    { ST_CONTROL_RC,            BUTTON_DOWN,    ST_CONTROL_RC },
+    { ST_CONTROL_RC,            BUTTON_UP,      ST_CONTROL_BLACKBOX },
+    { ST_CONTROL_RC,            BUTTON_DOWN,    ST_CONTROL_POSE },
     { ST_CONTROL_RC,            BUTTON_LEFT,    ST_CONTROL_MENU },
     { ST_CONTROL_RC,            BUTTON_RIGHT,   ST_CONTROL_RC_SEL },
 
+    { ST_CONTROL_POSE,          BUTTON_UP,      ST_CONTROL_RC },
+    { ST_CONTROL_POSE,          BUTTON_DOWN,    ST_CONTROL_BLACKBOX },
+    { ST_CONTROL_POSE,          BUTTON_LEFT,    ST_CONTROL_MENU },
+    { ST_CONTROL_POSE,          BUTTON_RIGHT,   ST_CONTROL_POSE_SEL },
+
+    { ST_CONTROL_BLACKBOX,      BUTTON_UP,      ST_CONTROL_POSE },
+    { ST_CONTROL_BLACKBOX,      BUTTON_DOWN,    ST_CONTROL_RC },
+    { ST_CONTROL_BLACKBOX,      BUTTON_LEFT,    ST_CONTROL_MENU },
+    { ST_CONTROL_BLACKBOX,      BUTTON_RIGHT,   ST_CONTROL_BLACKBOX_SEL },
+
     { ST_IMU_PITCH,             BUTTON_UP,      ST_IMU_RAW },
     { ST_IMU_PITCH,             BUTTON_DOWN,    ST_IMU_RAW },
     { ST_IMU_PITCH,             BUTTON_LEFT,    ST_IMU_MENU },
@@ -223,6 +357,31 @@ const menu_state_next ui_menu_state_next[] PROGMEM =
     { ST_IMU_RAW,               BUTTON_LEFT,    ST_IMU_MENU },
     { ST_IMU_RAW,               BUTTON_RIGHT,   ST_IMU_RAW_SEL },
 
+    { ST_PROFILE_STAGES,        BUTTON_UP,      ST_PROFILE_BENCH },
+    { ST_PROFILE_STAGES,        BUTTON_DOWN,    ST_PROFILE_DEADLINE },
+    { ST_PROFILE_STAGES,        BUTTON_LEFT,    ST_PROFILE_MENU },
+    { ST_PROFILE_STAGES,        BUTTON_RIGHT,   ST_PROFILE_STAGES_SEL },
+
+    { ST_PROFILE_DEADLINE,      BUTTON_UP,      ST_PROFILE_STAGES },
+    { ST_PROFILE_DEADLINE,      BUTTON_DOWN,    ST_PROFILE_LOAD },
+    { ST_PROFILE_DEADLINE,      BUTTON_LEFT,    ST_PROFILE_MENU },
+    { ST_PROFILE_DEADLINE,      BUTTON_RIGHT,   ST_PROFILE_DEADLINE_SEL },
+
+    { ST_PROFILE_LOAD,          BUTTON_UP,      ST_PROFILE_DEADLINE },
+    { ST_PROFILE_LOAD,          BUTTON_DOWN,    ST_PROFILE_JITTER },
+    { ST_PROFILE_LOAD,          BUTTON_LEFT,    ST_PROFILE_MENU },
+    { ST_PROFILE_LOAD,          BUTTON_RIGHT,   ST_PROFILE_LOAD_SEL },
+
+    { ST_PROFILE_JITTER,        BUTTON_UP,      ST_PROFILE_LOAD },
+    { ST_PROFILE_JITTER,        BUTTON_DOWN,    ST_PROFILE_BENCH },
+    { ST_PROFILE_JITTER,        BUTTON_LEFT,    ST_PROFILE_MENU },
+    { ST_PROFILE_JITTER,        BUTTON_RIGHT,   ST_PROFILE_JITTER_SEL },
+
+    { ST_PROFILE_BENCH,         BUTTON_UP,      ST_PROFILE_JITTER },
+    { ST_PROFILE_BENCH,         BUTTON_DOWN,    ST_PROFILE_STAGES },
+    { ST_PROFILE_BENCH,         BUTTON_LEFT,    ST_PROFILE_MENU },
+    { ST_PROFILE_BENCH,         BUTTON_RIGHT,   ST_PROFILE_BENCH_SEL },
+
     {0,                         0,              0}
 };
 
@@ -252,11 +411,17 @@ const menu_state ui_menu_state[] PROGMEM =
     { ST_BALANCE_D_GAIN,        MT_BALANCE_D_GAIN,          NULL },
     { ST_BALANCE_I_GAIN,        MT_BALANCE_I_GAIN,          NULL },
     { ST_BALANCE_T_COMP,        MT_BALANCE_T_COMP,          NULL },
+    { ST_BALANCE_MODE,          MT_BALANCE_MODE,            NULL },
+    { ST_BALANCE_SF_GAINS,      MT_BALANCE_SF_GAINS,        NULL },
+    { ST_BALANCE_SCHEDULE,      MT_BALANCE_SCHEDULE,        NULL },
 
     { ST_BALANCE_P_GAIN_SEL,    NULL,                       ui_balance_p_gain },
     { ST_BALANCE_D_GAIN_SEL,    NULL,                       ui_balance_d_gain },
     { ST_BALANCE_I_GAIN_SEL,    NULL,                       ui_balance_i_gain },
     { ST_BALANCE_T_COMP_SEL,    NULL,                       ui_balance_t_comp },
+    { ST_BALANCE_MODE_SEL,      NULL,                       ui_balance_mode },
+    { ST_BALANCE_SF_GAINS_SEL,  NULL,                       ui_balance_sf_gains },
+    { ST_BALANCE_SCHEDULE_SEL,  NULL,                       ui_balance_schedule },
 
     { ST_SPEED_MENU,            MT_SPEED_MENU,              NULL },
     { ST_SPEED_P_GAIN,          MT_SPEED_P_GAIN,            NULL },
@@ -269,8 +434,12 @@ const menu_state ui_menu_state[] PROGMEM =
 
     { ST_CONTROL_MENU,          MT_CONTROL_MENU,            NULL },
     { ST_CONTROL_RC,            MT_CONTROL_RC,              NULL },
+    { ST_CONTROL_POSE,          MT_CONTROL_POSE,            NULL },
+    { ST_CONTROL_BLACKBOX,      MT_CONTROL_BLACKBOX,        NULL },
 
     { ST_CONTROL_RC_SEL,        NULL,                       ui_control_rc },
+    { ST_CONTROL_POSE_SEL,      NULL,                       ui_control_pose },
+    { ST_CONTROL_BLACKBOX_SEL,  NULL,                       ui_control_blackbox },
 
     { ST_IMU_MENU,              MT_IMU_MENU,                NULL },
     { ST_IMU_PITCH,             MT_IMU_PITCH,               NULL },
@@ -279,6 +448,19 @@ const menu_state ui_menu_state[] PROGMEM =
     { ST_IMU_PITCH_SEL,         NULL,                       ui_imu_pitch },
     { ST_IMU_RAW_SEL,           NULL,                       ui_imu_raw },
 
+    { ST_PROFILE_MENU,          MT_PROFILE_MENU,            NULL },
+    { ST_PROFILE_STAGES,        MT_PROFILE_STAGES,          NULL },
+    { ST_PROFILE_DEADLINE,      MT_PROFILE_DEADLINE,        NULL },
+    { ST_PROFILE_LOAD,          MT_PROFILE_LOAD,            NULL },
+    { ST_PROFILE_JITTER,        MT_PROFILE_JITTER,          NULL },
+    { ST_PROFILE_BENCH,         MT_PROFILE_BENCH,           NULL },
+
+    { ST_PROFILE_STAGES_SEL,    NULL,                       ui_profile_stages },
+    { ST_PROFILE_DEADLINE_SEL,  NULL,                       ui_profile_deadline },
+    { ST_PROFILE_LOAD_SEL,      NULL,                       ui_profile_load },
+    { ST_PROFILE_JITTER_SEL,    NULL,                       ui_profile_jitter },
+    { ST_PROFILE_BENCH_SEL,     NULL,                       ui_profile_bench },
+
     { ST_BOOT_MENU,             MT_BOOT_MENU,               NULL },
     { ST_BOOT_ENABLE,           NULL,                       ui_boot_enable },
 
@@ -512,6 +694,96 @@ static uint8_t ui_balance_t_comp(uint8_t input)
 }
 
 
+static uint8_t ui_balance_mode(uint8_t input)
+// Handle selecting the ipd or state feedback balance controller.
+{
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_BALANCE_MODE;
+
+    // Handle the input.
+    if ((input == BUTTON_UP) || (input == BUTTON_DOWN))
+    {
+        // Toggle the value.
+        balance_mode_set(balance_mode_get() == BALANCE_MODE_STATEFB ? BALANCE_MODE_IPD : BALANCE_MODE_STATEFB);
+    }
+
+    // Update the LCD with the robot state.
+    lcd_puts_P(MT_BALANCE_MODE);
+    lcd_puts_P(balance_mode_get() == BALANCE_MODE_STATEFB ? PSTR("\r\nState Feedback") : PSTR("\r\nIPD"));
+
+    // Stay in this state.
+    return ST_BALANCE_MODE_SEL;
+}
+
+
+static uint8_t ui_balance_sf_gains(uint8_t input)
+// Handle setting the state feedback gains.  Left and right select the
+// gain and up and down adjust it.
+{
+    static uint8_t index;
+    int16_t gains[STATEFB_STATES];
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_BALANCE_SF_GAINS;
+
+    // Select the gain.
+    if (input == BUTTON_LEFT) index = index > 0 ? index - 1 : STATEFB_STATES - 1;
+    if (input == BUTTON_RIGHT) index = index < STATEFB_STATES - 1 ? index + 1 : 0;
+
+    // Get the gains.
+    balance_statefb_gains_get(&gains[STATEFB_ANGLE], &gains[STATEFB_RATE], &gains[STATEFB_POSITION], &gains[STATEFB_VELOCITY]);
+
+    // Handle the input.
+    if (input == BUTTON_UP) ++gains[index];
+    if (input == BUTTON_DOWN) --gains[index];
+    if ((input == BUTTON_UP) || (input == BUTTON_DOWN))
+        balance_statefb_gains_set(&gains[STATEFB_ANGLE], &gains[STATEFB_RATE], &gains[STATEFB_POSITION], &gains[STATEFB_VELOCITY]);
+
+    // Update the LCD with the selected gain.
+    lcd_puts_P(MT_BALANCE_SF_GAINS);
+    lcd_printf_P(PSTR("\r\n%c %i"), pgm_read_byte_near(&ui_sf_gain_names[index]), gains[index]);
+
+    // Stay in this state.
+    return ST_BALANCE_SF_GAINS_SEL;
+}
+
+
+static uint8_t ui_balance_schedule(uint8_t input)
+// Handle setting the gain schedule scale factors.  Left and right step
+// through the p and then i table entries and up and down adjust them.
+{
+    static uint8_t cell;
+    uint8_t table;
+    uint8_t pitch;
+    uint8_t speed;
+    int16_t scale;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_BALANCE_SCHEDULE;
+
+    // Select the table entry.
+    if (input == BUTTON_LEFT) cell = cell > 0 ? cell - 1 : 2 * GAINSCHED_PITCHES * GAINSCHED_SPEEDS - 1;
+    if (input == BUTTON_RIGHT) cell = cell < 2 * GAINSCHED_PITCHES * GAINSCHED_SPEEDS - 1 ? cell + 1 : 0;
+    table = cell / (GAINSCHED_PITCHES * GAINSCHED_SPEEDS);
+    pitch = (cell / GAINSCHED_SPEEDS) % GAINSCHED_PITCHES;
+    speed = cell % GAINSCHED_SPEEDS;
+
+    // Get the scale factor.
+    scale = balance_schedule_get(table, pitch, speed);
+
+    // Handle the input.
+    if (input == BUTTON_UP) { scale += 8; balance_schedule_set(table, pitch, speed, scale); }
+    if (input == BUTTON_DOWN) { scale -= 8; balance_schedule_set(table, pitch, speed, scale); }
+
+    // Update the LCD with the table, pitch row, speed column and scale factor.
+    lcd_puts_P(MT_BALANCE_SCHEDULE);
+    lcd_printf_P(PSTR("\r\n%c %u %u %i"), table == BALANCE_SCHEDULE_P ? 'P' : 'I', pitch, speed, scale);
+
+    // Stay in this state.
+    return ST_BALANCE_SCHEDULE_SEL;
+}
+
+
 static uint8_t ui_speed_p_gain(uint8_t input)
 // Handle setting the p gain value.
 {
@@ -605,6 +877,58 @@ static uint8_t ui_control_rc(uint8_t input)
 }
 
 
+static uint8_t ui_control_pose(uint8_t input)
+// Display the odometry pose.  The right button resets the pose.
+{
+    int32_t x;
+    int32_t y;
+    uint16_t heading;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_CONTROL_POSE;
+
+    // Reset the pose.
+    if (input == BUTTON_RIGHT) odometry_reset();
+
+    // Get the pose.
+    odometry_pose_get(&x, &y, &heading);
+
+    // Update the LCD with the position in millimeters and heading in degrees.
+    lcd_puts_P(MT_CONTROL_POSE);
+    lcd_printf_P(PSTR("\r\n%ld %ld %u"), x >> 16, y >> 16, (uint16_t) (((uint32_t) heading * 360) >> 16));
+
+    // Stay in this state.
+    return ST_CONTROL_POSE_SEL;
+}
+
+
+static uint8_t ui_control_blackbox(uint8_t input)
+// Display the blackbox state and records.  The right button freezes a
+// running blackbox and rearms a frozen one.
+{
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_CONTROL_BLACKBOX;
+
+    // Freeze or rearm the blackbox.
+    if (input == BUTTON_RIGHT)
+    {
+        if (blackbox_state_get() == BLACKBOX_RUNNING)
+            blackbox_trigger(BLACKBOX_USER);
+        else
+            blackbox_reset();
+    }
+
+    // Update the LCD with the blackbox state.
+    lcd_puts_P(MT_CONTROL_BLACKBOX);
+    lcd_puts_P(PSTR("\r\n"));
+    lcd_puts_P((PGM_P) pgm_read_word_near(&ui_blackbox_text[blackbox_state_get()]));
+    lcd_printf_P(PSTR(" %u"), (uint16_t) blackbox_count_get());
+
+    // Stay in this state.
+    return ST_CONTROL_BLACKBOX_SEL;
+}
+
+
 static uint8_t ui_imu_pitch(uint8_t input)
 // Display IMU pitch values.
 {
@@ -648,6 +972,135 @@ static uint8_t ui_imu_raw(uint8_t input)
 }
 
 
+static uint8_t ui_profile_stages(uint8_t input)
+// Display the execution times of the control loop stages.
+{
+    profile_stats stats;
+    static uint8_t stage;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_PROFILE_STAGES;
+
+    // Select the stage to display.
+    if (input == BUTTON_UP) stage = stage > 0 ? stage - 1 : PROFILE_COUNT - 1;
+    if (input == BUTTON_DOWN) stage = stage < PROFILE_COUNT - 1 ? stage + 1 : 0;
+
+    // Get the stage statistics.
+    profile_stats_get(stage, &stats);
+
+    // Update the LCD with the minimum, mean and maximum times in microseconds.
+    lcd_puts_P((PGM_P) pgm_read_word_near(&ui_profile_text[stage]));
+    lcd_printf_P(PSTR("\r\n%u %u %u"), stats.min / PROFILE_TICKS_PER_US, stats.mean / PROFILE_TICKS_PER_US, stats.max / PROFILE_TICKS_PER_US);
+
+    // Stay in this state.
+    return ST_PROFILE_STAGES_SEL;
+}
+
+
+static uint8_t ui_profile_deadline(uint8_t input)
+// Display the missed control loop deadlines and the worst case slack.
+{
+    profile_stats stats;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_PROFILE_DEADLINE;
+
+    // Reset the statistics with the right button.
+    if (input == BUTTON_RIGHT) profile_reset();
+
+    // Get the loop statistics.
+    profile_stats_get(PROFILE_LOOP, &stats);
+
+    // Update the LCD with the missed deadlines and the slack in microseconds.
+    lcd_puts_P(MT_PROFILE_DEADLINE);
+    lcd_printf_P(PSTR("\r\n%u %d"), profile_misses_get(), (int16_t) (((int32_t) PROFILE_DEADLINE - stats.max) / PROFILE_TICKS_PER_US));
+
+    // Stay in this state.
+    return ST_PROFILE_DEADLINE_SEL;
+}
+
+
+static uint8_t ui_profile_load(uint8_t input)
+// Display the worst case load of each tick in the control schedule.
+{
+    uint16_t load;
+    uint16_t worst_load;
+    uint8_t worst_slot;
+    static uint8_t slot;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_PROFILE_LOAD;
+
+    // Select the slot to display.
+    if (input == BUTTON_UP) slot = slot > 0 ? slot - 1 : SCHED_SLOTS - 1;
+    if (input == BUTTON_DOWN) slot = slot < SCHED_SLOTS - 1 ? slot + 1 : 0;
+
+    // Get the load of the slot and the worst slot.
+    load = sched_load_get(slot);
+    worst_slot = sched_worst_get(&worst_load);
+
+    // Update the LCD with the slot load and the worst slot load in microseconds.
+    lcd_puts_P(MT_PROFILE_LOAD);
+    lcd_printf_P(PSTR("\r\n%u:%u W%u:%u"), slot, load / PROFILE_TICKS_PER_US, worst_slot, worst_load / PROFILE_TICKS_PER_US);
+
+    // Stay in this state.
+    return ST_PROFILE_LOAD_SEL;
+}
+
+
+static uint8_t ui_profile_jitter(uint8_t input)
+// Display the control tick wake up latency and overruns.
+{
+    profile_stats stats;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_PROFILE_JITTER;
+
+    // Reset the statistics with the right button.
+    if (input == BUTTON_RIGHT) tick_reset();
+
+    // Get the tick statistics.
+    tick_stats_get(&stats);
+
+    // Update the LCD with the minimum and maximum latency, the jitter and the overruns.
+    lcd_puts_P(MT_PROFILE_JITTER);
+    lcd_printf_P(PSTR("\r\n%u %u %u %u"), stats.min / PROFILE_TICKS_PER_US, stats.max / PROFILE_TICKS_PER_US,
+                 (stats.max - stats.min) / PROFILE_TICKS_PER_US, tick_overruns_get());
+
+    // Stay in this state.
+    return ST_PROFILE_JITTER_SEL;
+}
+
+
+static uint8_t ui_profile_bench(uint8_t input)
+// Display the cycles taken by the fixed point math benchmarks.
+{
+    static uint8_t bench;
+    static uint16_t cycles;
+
+    // Exit this state with center button.
+    if (input == BUTTON_CENTER) return ST_PROFILE_BENCH;
+
+    // Select the benchmark to display.
+    if (input == BUTTON_UP) bench = bench > 0 ? bench - 1 : BENCH_COUNT - 1;
+    if (input == BUTTON_DOWN) bench = bench < BENCH_COUNT - 1 ? bench + 1 : 0;
+
+    // The benchmark runs with interrupts disabled so only run it the first
+    // time through and then on a button press.
+    if ((input != BUTTON_NONE) || !cycles) cycles = bench_run(bench);
+
+    // Update the LCD with the benchmark cycles and any cycle budget.
+    lcd_puts_P((PGM_P) pgm_read_word_near(&ui_bench_text[bench]));
+    if (bench_budget_get(bench))
+        lcd_printf_P(PSTR("\r\n%u of %u"), cycles, bench_budget_get(bench));
+    else
+        lcd_printf_P(PSTR("\r\n%u"), cycles);
+
+    // Stay in this state.
+    return ST_PROFILE_BENCH_SEL;
+}
+
+
 static uint8_t ui_boot_enable(uint8_t input)
 // Manually enter the bootloader.
 {
@@ -660,6 +1113,9 @@ static uint8_t ui_boot_enable(uint8_t input)
         // Give feedback.
         lcd_puts_P(PSTR("\x0c" "Starting\r\nbootloader..."));
 
+        // Keep the bootloader reset from freezing the blackbox.
+        blackbox_reset();
+
         // Start the bootloader.
         bootloader_start();
     }
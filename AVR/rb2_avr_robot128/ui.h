@@ -51,11 +51,17 @@
 #define ST_BALANCE_D_GAIN       32
 #define ST_BALANCE_I_GAIN       33
 #define ST_BALANCE_T_COMP       34
+#define ST_BALANCE_MODE         35
+#define ST_BALANCE_SF_GAINS     36
+#define ST_BALANCE_SCHEDULE     37
 
 #define ST_BALANCE_P_GAIN_SEL   41
 #define ST_BALANCE_D_GAIN_SEL   42
 #define ST_BALANCE_I_GAIN_SEL   43
 #define ST_BALANCE_T_COMP_SEL   44
+#define ST_BALANCE_MODE_SEL     45
+#define ST_BALANCE_SF_GAINS_SEL 46
+#define ST_BALANCE_SCHEDULE_SEL 47
 
 #define ST_SPEED_MENU           50
 #define ST_SPEED_P_GAIN         51
@@ -68,8 +74,12 @@
 
 #define ST_CONTROL_MENU         70
 #define ST_CONTROL_RC           71
+#define ST_CONTROL_POSE         72
+#define ST_CONTROL_BLACKBOX     73
 
 #define ST_CONTROL_RC_SEL       81
+#define ST_CONTROL_POSE_SEL     82
+#define ST_CONTROL_BLACKBOX_SEL 83
 
 #define ST_IMU_MENU             90
 #define ST_IMU_PITCH            91
@@ -81,4 +91,17 @@
 #define ST_BOOT_MENU            110
 #define ST_BOOT_ENABLE          111
 
+#define ST_PROFILE_MENU         120
+#define ST_PROFILE_STAGES       121
+#define ST_PROFILE_DEADLINE     122
+#define ST_PROFILE_LOAD         123
+#define ST_PROFILE_JITTER       124
+#define ST_PROFILE_BENCH        125
+
+#define ST_PROFILE_STAGES_SEL   131
+#define ST_PROFILE_DEADLINE_SEL 132
+#define ST_PROFILE_LOAD_SEL     133
+#define ST_PROFILE_JITTER_SEL   134
+#define ST_PROFILE_BENCH_SEL    135
+
 #endif // _RB2_UI_H_
@@ -42,12 +42,33 @@
 static uint8_t uio_leds_on;
 static uint8_t uio_leds_blinking;
 
-// Buttons state.
-static uint8_t uio_buttons_buffer;
-
-// RC state.
-static int8_t uio_rc_chan1;
-static int8_t uio_rc_chan2;
+// Polls between exchanges of the LEDs for the receiver frame.  The poll
+// runs every 40 milliseconds so the exchange runs at most every 160.
+#define UIO_EXCHANGE_POLLS  4
+
+// LEDs state last sent to the module.
+static uint8_t uio_leds_sent_on;
+static uint8_t uio_leds_sent_blinking;
+static uint8_t uio_exchange_polls;
+
+// Set when a poll saw a new receiver frame that has not been exchanged.
+static uint8_t uio_rc_pending;
+
+// Buttons state including the change count last read from the module.
+// Presses are queued with their module time in milliseconds so several
+// presses read in one burst are not lost.
+static uint8_t uio_buttons_changes;
+static uint8_t uio_buttons_head;
+static uint8_t uio_buttons_tail;
+static uint8_t uio_buttons_queue[4];
+static uint16_t uio_buttons_times[4];
+static uint16_t uio_buttons_time;
+
+// RC state of all receiver channels along with the sequence and time of
+// the receiver frame they came from.
+static int16_t uio_rc[UIO_RC_CHANNELS];
+static uint8_t uio_rc_sequence;
+static uint16_t uio_rc_time;
 
 // Task control.
 AVRX_MUTEX(uio_mutex);
@@ -105,16 +126,75 @@ void uio_leds_reset(uint8_t leds)
 
 INTERFACE void AvrXSetObjectSemaphore(pMutex);
 INTERFACE void AvrXWaitObjectSemaphore(pMutex);
-INTERFACE Mutex AvrXTestObjectSemaphore(pMutex);
+
+static void uio_buttons_put(uint8_t button, uint16_t time)
+// Queue up the button pressed and signal the next button.
+{
+    uint8_t next_head;
+
+    // Get exclusive access to the user I/O data.
+    AvrXWaitSemaphore(&uio_mutex);
+
+    // Determine the next head within the queue.
+    next_head = (uio_buttons_head + 1) & 0x03;
+
+    // Have we wrapped the queue?
+    if (next_head != uio_buttons_tail)
+    {
+        // No. Add the button and its time to the queue.
+        uio_buttons_queue[uio_buttons_head] = button;
+        uio_buttons_times[uio_buttons_head] = time;
+
+        // Increment the head of the queue.
+        uio_buttons_head = next_head;
+
+        // Signal the next button.
+        AvrXSetObjectSemaphore((pMutex) &uio_buttons_timeout);
+    }
+
+    // Release exclusive access to the user I/O data.
+    AvrXSetSemaphore(&uio_mutex);
+}
+
+
+static uint8_t uio_buttons_get(void)
+// De-queue the next pending button or BUTTON_NONE if none is queued.
+{
+    uint8_t button = BUTTON_NONE;
+
+    // Get exclusive access to the user I/O data.
+    AvrXWaitSemaphore(&uio_mutex);
+
+    // Is there a button in the queue?
+    if (uio_buttons_tail != uio_buttons_head)
+    {
+        // Get the button and its time from the queue.
+        button = uio_buttons_queue[uio_buttons_tail];
+        uio_buttons_time = uio_buttons_times[uio_buttons_tail];
+
+        // Increment the tail of the queue.
+        uio_buttons_tail = (uio_buttons_tail + 1) & 0x03;
+    }
+
+    // Forget the signal once the queue is empty so the next wait blocks.
+    if (uio_buttons_tail == uio_buttons_head) uio_buttons_timeout.semaphore = SEM_PEND;
+
+    // Release exclusive access to the user I/O data.
+    AvrXSetSemaphore(&uio_mutex);
+
+    return button;
+}
+
 
 uint8_t uio_next_button(uint16_t timeout)
 // Get the next button or BUTTON_NONE if timeout expired.  A timeout of
 // zero indicates that no timeout should be used.
 {
-    uint8_t rv = BUTTON_NONE;
+    uint8_t rv;
 
     // Is a button already waiting?
-    if ((AvrXTestObjectSemaphore((pMutex) &uio_buttons_timeout) != SEM_DONE) && (timeout > 0))
+    rv = uio_buttons_get();
+    if ((rv == BUTTON_NONE) && (timeout > 0))
     {
         // Start the timer.
         AvrXStartTimer(&uio_buttons_timeout, timeout);
@@ -122,21 +202,23 @@ uint8_t uio_next_button(uint16_t timeout)
         // Wait for timer or signal to wake up task.
         AvrXWaitTimer(&uio_buttons_timeout);
 
-        // If we cancel the timer it will return non-zero if the timer
-        // is still on the queue.  This indicates we were woken by a signal
-        // rather than the expiration of the timer and a button is ready.
-        if (AvrXCancelTimer(&uio_buttons_timeout) != 0) rv = uio_buttons_buffer;
+        // Cancel the timer in case we were woken by a signal.
+        AvrXCancelTimer(&uio_buttons_timeout);
 
         // Reset the timer semaphore after being canceled.
         uio_buttons_timeout.semaphore = SEM_PEND;
+
+        // Get the button if one arrived.
+        rv = uio_buttons_get();
     }
     else
     {
         // Wait for the button signal without timeout.
-        AvrXWaitObjectSemaphore((pMutex) &uio_buttons_timeout);
-
-        // Return the button.
-        rv = uio_buttons_buffer;
+        while (rv == BUTTON_NONE)
+        {
+            AvrXWaitObjectSemaphore((pMutex) &uio_buttons_timeout);
+            rv = uio_buttons_get();
+        }
     }
 
     return rv;
@@ -146,41 +228,82 @@ uint8_t uio_next_button(uint16_t timeout)
 void uio_get_rc(int8_t *chan1, int8_t *chan2)
 // Get the RC channel 1 (left/right) and channel 3 (forwards/backwards) values.
 {
-    // Return the channel 1 and channel 3 values.
-    if (chan1) *chan1 = uio_rc_chan1;
-    if (chan2) *chan2 = uio_rc_chan2;
+    // Return the channel 1 and channel 3 values scaled to 8 bits.
+    if (chan1) *chan1 = (int8_t) (uio_rc[0] / 8);
+    if (chan2) *chan2 = (int8_t) (uio_rc[1] / 8);
 }
-
 
-void uio_init(void)
-// User I/O module init function.
+
+uint8_t uio_get_rc_wide(int16_t *chan1, int16_t *chan2, uint16_t *time)
+// Get the full resolution RC channel 1 and channel 3 values and the time
+// of their receiver frame.  Returns the frame sequence which only changes
+// when a new frame is received.
 {
-    // Prime the mutex.
-    AvrXSetSemaphore(&uio_mutex);
+    if (chan1) *chan1 = uio_rc[0];
+    if (chan2) *chan2 = uio_rc[1];
+    if (time) *time = uio_rc_time;
+
+    return uio_rc_sequence;
 }
 
 
-static void uio_send_leds(uint8_t command, uint8_t leds)
-// Sends the LEDs to the user I/O module.
+uint16_t uio_button_time(void)
+// Get the time in milliseconds on the user I/O module of the last button
+// press.  Only differences between these times are meaningful.
 {
-    // Send the set LEDs command.
-    usart_xmit_discard_echo(command);
+    return uio_buttons_time;
+}
 
-    // Get the response.
-    usart_recv();
 
-    // Send the LEDs to be set.
-    usart_xmit_discard_echo(leds);
+int8_t uio_get_rc_channel(uint8_t channel)
+// Get the value of any of the receiver channels scaled to 8 bits.
+{
+    return (int8_t) (uio_rc[channel % UIO_RC_CHANNELS] / 8);
+}
 
-    // Get the response.
-    usart_recv();
+
+static int16_t uio_recv_word(void)
+// Receive a 16 bit word high byte first.
+{
+    uint16_t data;
+
+    data = usart_recv() << 8;
+    data |= usart_recv() & 0xff;
+
+    return (int16_t) data;
+}
+
+
+void uio_init(void)
+// User I/O module init function.
+{
+    // The LEDs are sent with the first exchange.
+    uio_leds_sent_on = 0xff;
+    uio_leds_sent_blinking = 0xff;
+
+    // Prime the mutex.
+    AvrXSetSemaphore(&uio_mutex);
 }
 
 
 void uio_update(void)
-// User I/O module update function.
+// User I/O module update function.  The module is polled for its button
+// change count and receiver frame sequence.  The LEDs are exchanged for
+// the latest receiver frame only when either changed and at most every
+// UIO_EXCHANGE_POLLS polls, and the exchange returns the change count in
+// place of the poll.  The button events are read as soon as the count
+// changes.
 {
+    static uint8_t i;
+    static uint8_t count;
+    static uint8_t event;
+    static uint8_t changes;
+    static uint8_t sequence;
+    static uint8_t leds_on;
+    static uint8_t leds_blinking;
     static uint16_t response;
+    static uint16_t time;
+    static int16_t rc[UIO_RC_CHANNELS];
 
     // Grab access to the USART.
     usart_grab_access();
@@ -194,56 +317,74 @@ void uio_update(void)
     // Validate the response.
     if (response == 0x00A5)
     {
-        // Get exclusive access to the user I/O data.
+        // Get the LED state.
         AvrXWaitSemaphore(&uio_mutex);
-
-        // Send the set LEDs command.
-        uio_send_leds(0x0001, uio_leds_on);
-
-        // Send the set LEDs command.
-        uio_send_leds(0x0002, uio_leds_blinking);
-
-        // Send the set LEDs command.
-        uio_send_leds(0x0003, ~(uio_leds_on | uio_leds_blinking));
-
-        // Release exclusive access to the user I/O data.
+        leds_on = uio_leds_on;
+        leds_blinking = uio_leds_blinking;
         AvrXSetSemaphore(&uio_mutex);
 
-        // Get the button state.
-        usart_xmit_discard_echo(0x0004);
-
-        // Receive the response which is the button press.
-        response = usart_recv();
-
-        // Did we receive a button press?
-        if ((response > 0) && (response < 6))
+        // Exchange the LED state for the receiver frame if either changed.
+        if (uio_exchange_polls) --uio_exchange_polls;
+        if ((uio_exchange_polls == 0) &&
+            (uio_rc_pending || (leds_on != uio_leds_sent_on) || (leds_blinking != uio_leds_sent_blinking)))
         {
-            // Buffer the button.
-            uio_buttons_buffer = (uint8_t) response;
-
-            // Signal the next button.
-            AvrXSetObjectSemaphore((pMutex) &uio_buttons_timeout);
+            usart_xmit_discard_echo(0x000c);
+            usart_xmit_discard_echo(leds_on);
+            usart_xmit_discard_echo(leds_blinking);
+
+            // Receive the button change count.
+            changes = (uint8_t) usart_recv();
+
+            // Receive the frame sequence, time and full resolution channels.
+            sequence = (uint8_t) usart_recv();
+            time = (uint16_t) uio_recv_word();
+            for (i = 0; i < UIO_RC_CHANNELS; ++i) rc[i] = uio_recv_word();
+
+            // Keep the frame and LED state only from a complete reply so
+            // both are exchanged again if the module stopped answering.
+            if (!usart_timed_out_get())
+            {
+                uio_leds_sent_on = leds_on;
+                uio_leds_sent_blinking = leds_blinking;
+                uio_rc_sequence = sequence;
+                uio_rc_time = time;
+                for (i = 0; i < UIO_RC_CHANNELS; ++i) uio_rc[i] = rc[i];
+                uio_rc_pending = 0;
+            }
+
+            uio_exchange_polls = UIO_EXCHANGE_POLLS;
         }
+        else
+        {
+            // Read the button change count and receiver frame sequence.
+            usart_xmit_discard_echo(0x000d);
+            changes = (uint8_t) usart_recv();
+            sequence = (uint8_t) usart_recv();
 
-        // IMU RC Channel 1
-
-        // Get the channel 1 byte.
-        usart_xmit_discard_echo(0x05);
-
-        // Receive the channel 1 byte.
-        uio_rc_chan1 = (int8_t) usart_recv();
-
-        // IMU RC Channel 2
-
-        // Get the channel 3 byte.
-        usart_xmit_discard_echo(0x06);
+            // Exchange a new receiver frame when the exchange is next due.
+            if ((sequence != uio_rc_sequence) && !usart_timed_out_get()) uio_rc_pending = 1;
+        }
 
-        // Receive the channel 2 byte.
-        uio_rc_chan2 = (int8_t) usart_recv();
+        // Read the button events if the buttons changed and the module is
+        // still answering.
+        if ((changes != uio_buttons_changes) && !usart_timed_out_get())
+        {
+            uio_buttons_changes = changes;
+
+            // Receive the number of events and then each event.
+            usart_xmit_discard_echo(0x000e);
+            count = (uint8_t) usart_recv();
+            for (i = 0; (i < count) && !usart_timed_out_get(); ++i)
+            {
+                event = (uint8_t) usart_recv();
+                response = (uint16_t) uio_recv_word();
+
+                // Queue a button press with its time.
+                if ((event > 0) && (event < 6)) uio_buttons_put(event, response);
+            }
+        }
     }
 
     // Release access to the USART.
     usart_release_access();
 }
-
-
@@ -27,6 +27,9 @@
 #ifndef _RB2_UIO_H_
 #define _RB2_UIO_H_ 1
 
+// Number of RC receiver channels.
+#define UIO_RC_CHANNELS 6
+
 // Button constants.
 #define BUTTON_NONE     0
 #define BUTTON_UP       1
@@ -39,7 +42,10 @@ void uio_leds_set(uint8_t leds);
 void uio_leds_blink(uint8_t leds);
 void uio_leds_reset(uint8_t leds);
 uint8_t uio_next_button(uint16_t timeout);
+uint16_t uio_button_time(void);
 void uio_get_rc(int8_t *chan1, int8_t *chan2);
+uint8_t uio_get_rc_wide(int16_t *chan1, int16_t *chan2, uint16_t *time);
+int8_t uio_get_rc_channel(uint8_t channel);
 
 void uio_init(void);
 void uio_update(void);
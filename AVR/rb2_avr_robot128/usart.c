@@ -28,6 +28,8 @@
 #include <avr/interrupt.h>
 #include "avrx.h"
 #include "config.h"
+#include "mirror.h"
+#include "profile.h"
 #include "usart.h"
 
 #if (CPUCLK == 8000000)
@@ -43,17 +45,39 @@
 #endif
 
 AVRX_MUTEX(tx_ready);                   // AvrX semaphore for signaling TX routine.
-AVRX_MUTEX(rx_ready);                   // AvrX semaphore for signaling RX routine.
 AVRX_MUTEX(rx_default_ready);           // AvrX semaphore for signaling RX default routine.
 AVRX_MUTEX(rx_timeout);                 // AvrX semaphore for signaling RX timeout.
 AVRX_MUTEX(usart_mutex);                // AvrX semaphore USART access.
 
-// User I/O module timer control block.
-// TimerControlBlock rx_timer;
+// Receive timer control block.  The receive interrupt signals the timer
+// semaphore so a receive ends on the data or the deadline.
+TimerControlBlock rx_timer;
 
 // Indicates the current owner of the USART.
 volatile pProcessID usart_owner = NOPID;
 
+// Set when a receive missed its deadline since access was grabbed.
+static uint8_t usart_timed_out;
+
+#if BUS_MIRROR
+// Time the last word was received and the last word sent with bit 15
+// set until its echo is received.
+static volatile uint16_t usart_rx_time;
+static uint16_t usart_echo;
+
+
+static void usart_mirror(uint16_t data)
+// Mirror the received word marking the echo of the last word sent.
+{
+    uint8_t flags = 0;
+
+    if (usart_echo == (data | 0x8000)) flags = MIRROR_FLAG_SENT;
+    usart_echo = 0;
+
+    mirror_word(usart_rx_time, data, flags);
+}
+#endif
+
 void usart_init(void)
 //  Initialize the USART for 9 bit frame communication.
 {
@@ -81,7 +105,11 @@ void usart_init(void)
 void usart_grab_access(void)
 // Grab exclusive access to the USART.
 {
+#if BUS_MIRROR
+    uint16_t data;
+#else
     uint8_t dummy;
+#endif
 
     // Wait for exclusive access.
     AvrXWaitSemaphore(&usart_mutex);
@@ -90,7 +118,32 @@ void usart_grab_access(void)
     usart_owner = AvrXSelf();
 
     // Flush the receive buffer on the USART.
-    while (UCSR1A & (1<<RXC1)) dummy = UDR1;
+    while (UCSR1A & (1<<RXC1))
+    {
+#if BUS_MIRROR
+        // Mirror the stray word so it is seen even though it is discarded.
+        data = (UCSR1B & (1<<RXB81)) ? 0x0100 : 0x0000;
+        data |= UDR1;
+        mirror_word(profile_time(), data, MIRROR_FLAG_FLUSHED);
+#else
+        dummy = UDR1;
+#endif
+    }
+
+    // Forget a late signal and timeout from the previous owner.
+    rx_timer.semaphore = SEM_PEND;
+    usart_timed_out = 0;
+
+    // Enable the receive interrupt which a late word may have disabled.
+    UCSR1B |= (1<<RXCIE1);
+}
+
+
+uint8_t usart_timed_out_get(void)
+// Returns non-zero if a receive missed its deadline since access was
+// grabbed.  Data received in such an exchange should not be trusted.
+{
+    return usart_timed_out;
 }
 
 
@@ -118,6 +171,11 @@ void usart_xmit(uint16_t data)
         UCSR1B &= ~(1<<TXB81);
     UDR1 = (uint8_t) data;
 
+#if BUS_MIRROR
+    // Remember the word to recognize its echo.
+    usart_echo = data | 0x8000;
+#endif
+
     // Enable interrupt.
     UCSR1B |= (1<<UDRIE1);
 }
@@ -135,21 +193,71 @@ void usart_xmit_discard_echo(uint16_t data)
 
 
 uint16_t usart_recv(void)
-// Receive the character from the USART.
+// Return the next 9 bit word from the USART or -1 if no word arrives
+// within the receive deadline so a silent module cannot stall the
+// control loop.  Once a receive has timed out the rest of the exchange
+// returns -1 right away so a silent module costs a single deadline.
+{
+    uint16_t data;
+
+    // Do not wait again for a module that already missed a deadline.
+    if (usart_timed_out) return (uint16_t) -1;
+
+    // Receive the next word within the deadline.
+    data = usart_recv_timeout(USART_RECV_TIMEOUT);
+
+    // Remember the timeout for the rest of the exchange.
+    if (data == (uint16_t) -1) usart_timed_out = 1;
+
+    return data;
+}
+
+
+uint16_t usart_recv_timeout(uint16_t timeout)
+// Return the next 9 bit word from the USART or -1 if no word arrives
+// within the timeout in timer ticks.  Unlike usart_recv() a timeout is
+// not remembered, for the slave side where the bus master sets the pace.
 {
     uint8_t hi_byte;
     uint8_t lo_byte;
     uint16_t data;
 
-    // Wait for data to be available.
-    AvrXWaitSemaphore(&rx_ready);
+    // Is the serial port ready to receive data?
+    if (~UCSR1A & (1<<RXC1))
+    {
+        // Start the timer.
+        AvrXStartTimer(&rx_timer, timeout);
 
-    // Get the high and low byte of data.
-    hi_byte = (UCSR1B & (1<<RXB81)) ? 0x01 : 0x00;
-    lo_byte = UDR1;
+        // Wait for timer or signal to wake up task.
+        AvrXWaitTimer(&rx_timer);
 
-    // Set the combined 9 bit value.
-    data = (hi_byte << 8) | lo_byte;
+        // Cancel the timer in case of signal.
+        AvrXCancelTimer(&rx_timer);
+
+        // Reset the timer semaphore after being canceled.
+        rx_timer.semaphore = SEM_PEND;
+    }
+
+    // Is the serial port ready to receive data?
+    if (UCSR1A & (1<<RXC1))
+    {
+        // Get the high and low byte of data.
+        hi_byte = (UCSR1B & (1<<RXB81)) ? 0x01 : 0x00;
+        lo_byte = UDR1;
+
+        // Set the combined 9 bit value.
+        data = (hi_byte << 8) | lo_byte;
+
+#if BUS_MIRROR
+        // Mirror the word.
+        usart_mirror(data);
+#endif
+    }
+    else
+    {
+        // Return error character.
+        data = (uint16_t) -1;
+    }
 
     // Enable the receive interrupt.
     UCSR1B |= (1<<RXCIE1);
@@ -175,6 +283,11 @@ uint16_t usart_recv_default(void)
     // Set the combined 9 bit value.
     data = (hi_byte << 8) | lo_byte;
 
+#if BUS_MIRROR
+    // Mirror the word.
+    usart_mirror(data);
+#endif
+
     // Enable the receive interrupt.
     UCSR1B |= (1<<RXCIE1);
 
@@ -202,6 +315,8 @@ AVRX_SIGINT(USART1_UDRE_vect)
 }
 
 
+INTERFACE void AvrXIntSetObjectSemaphore(pMutex);
+
 AVRX_SIGINT(USART1_RX_vect)
 // USART receive interrupt handler.
 {
@@ -211,6 +326,11 @@ AVRX_SIGINT(USART1_RX_vect)
     // Disable the receive interrupt.
     UCSR1B &= ~(1<<RXCIE1);
 
+#if BUS_MIRROR
+    // Note when the word was received.
+    usart_rx_time = profile_time();
+#endif
+
     // Enable other interrupt activity.
     sei();
 
@@ -223,7 +343,7 @@ AVRX_SIGINT(USART1_RX_vect)
     else
     {
         // Signal the owned receiver task.
-        AvrXIntSetSemaphore(&rx_ready);
+        AvrXIntSetObjectSemaphore((pMutex) &rx_timer);
     }
 
     // Go  back to RTOS
@@ -27,12 +27,20 @@
 #ifndef _RB2_USART_H_
 #define _RB2_USART_H_ 1
 
+#include "config.h"
+
+// The receive deadline in timer ticks.  The timer resolution makes the
+// actual deadline up to one tick shorter.
+#define USART_RECV_TIMEOUT      (CONTROL_PERIOD / 2)
+
 void usart_init(void);
 void usart_grab_access(void);
 void usart_release_access(void);
 void usart_xmit(uint16_t data);
 void usart_xmit_discard_echo(uint16_t data);
 uint16_t usart_recv(void);
+uint16_t usart_recv_timeout(uint16_t timeout);
+uint8_t usart_timed_out_get(void);
 uint16_t usart_recv_default(void);
 
 #endif // _IMU_USART_H_
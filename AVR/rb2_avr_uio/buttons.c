@@ -40,6 +40,14 @@ static uint8_t buttons_head = 0;
 static uint8_t buttons_tail = 0;
 static uint8_t buttons_queue[4];
 
+// Press and release events with their time in milliseconds and a count
+// of changes so the master can tell when to read the events.
+static uint8_t buttons_changes = 0;
+static uint8_t buttons_event_head = 0;
+static uint8_t buttons_event_tail = 0;
+static uint8_t buttons_event_codes[BUTTONS_EVENTS];
+static uint16_t buttons_event_times[BUTTONS_EVENTS];
+
 uint8_t buttons_get(void)
 // De-queue the next pending button.
 {
@@ -91,6 +99,95 @@ static void buttons_put(uint8_t button)
 }
 
 
+uint8_t buttons_changes_get(void)
+// Get the count of button changes.  This wraps and only differs from an
+// earlier count if buttons have been pressed or released since.
+{
+    // A single byte read needs no exclusive access.
+    return buttons_changes;
+}
+
+
+uint8_t buttons_events_pending(void)
+// Get the number of queued button events.
+{
+    uint8_t pending;
+
+    // Get exclusive access to the button queue.
+    AvrXWaitSemaphore(&buttons_mutex);
+
+    // Determine the events in the queue.
+    pending = (buttons_event_head - buttons_event_tail) & (BUTTONS_EVENTS - 1);
+
+    // Give up exclusive access to the button queue.
+    AvrXSetSemaphore(&buttons_mutex);
+
+    return pending;
+}
+
+
+uint8_t buttons_event_get(uint16_t *time)
+// De-queue the next button event and its time.  Returns BUTTON_NONE if
+// there is no event.
+{
+    uint8_t event = BUTTON_NONE;
+
+    // Get exclusive access to the button queue.
+    AvrXWaitSemaphore(&buttons_mutex);
+
+    // Is there an event in the queue?
+    if (buttons_event_tail != buttons_event_head)
+    {
+        // Get the event from the queue.
+        event = buttons_event_codes[buttons_event_tail];
+        *time = buttons_event_times[buttons_event_tail];
+
+        // Increment the tail of the queue.
+        buttons_event_tail = (buttons_event_tail + 1) & (BUTTONS_EVENTS - 1);
+    }
+
+    // Give up exclusive access to the button queue.
+    AvrXSetSemaphore(&buttons_mutex);
+
+    return event;
+}
+
+
+static void buttons_event_put(uint8_t changed, uint8_t pressed, uint16_t time)
+// Queue up the press or release events of the changed buttons.
+{
+    uint8_t i;
+    uint8_t next_head;
+    static const uint8_t buttons[5] = { BUTTON_UP, BUTTON_RIGHT, BUTTON_LEFT, BUTTON_CENTER, BUTTON_DOWN };
+
+    // Get exclusive access to the button queue.
+    AvrXWaitSemaphore(&buttons_mutex);
+
+    // Buttons are on port D bits 2 to 6.
+    for (i = 0; i < 5; ++i)
+    {
+        if (!(changed & (0x04 << i))) continue;
+
+        // Count the change even if the queue is full.
+        ++buttons_changes;
+
+        // Determine the next head within the queue.
+        next_head = (buttons_event_head + 1) & (BUTTONS_EVENTS - 1);
+
+        // Add the event if the queue has not wrapped.
+        if (next_head != buttons_event_tail)
+        {
+            buttons_event_codes[buttons_event_head] = buttons[i] | ((pressed & (0x04 << i)) ? 0 : BUTTON_RELEASED);
+            buttons_event_times[buttons_event_head] = time;
+            buttons_event_head = next_head;
+        }
+    }
+
+    // Give up exclusive access to the button queue.
+    AvrXSetSemaphore(&buttons_mutex);
+}
+
+
 NAKEDFUNC(buttons_task)
 // Task to process buttons.
 {
@@ -101,6 +198,7 @@ NAKEDFUNC(buttons_task)
     static uint8_t previous_sample = 0;
     static uint8_t buttons_pressed = 0;
     static uint8_t debounced_state = 0;
+    static uint16_t buttons_time = 0;
 
     // Initialize the hardware. Set port D to inputs with internal pull-up resistors.
     DDRD &= ~((1<<DDD2) | (1<<DDD3) | (1<<DDD4) | (1<<DDD5) | (1<<DDD6));
@@ -114,6 +212,7 @@ NAKEDFUNC(buttons_task)
     {
         // Delay for 5 milliseconds.
         AvrXDelay(&buttons_timer, 5);
+        buttons_time += 5;
 
         // Read the current button sample.
         current_sample = ~PIND & 0x7c;
@@ -144,6 +243,10 @@ NAKEDFUNC(buttons_task)
 
         // Capture when buttons have been pressed.
         buttons_pressed |= (debounced_state & ~previous_state);
+
+        // Queue up the press and release events.
+        if (debounced_state != previous_state)
+            buttons_event_put(debounced_state ^ previous_state, debounced_state, buttons_time);
         previous_state = debounced_state;
 
         // Should we click?
@@ -35,7 +35,16 @@
 #define BUTTON_LEFT     4
 #define BUTTON_CENTER   5
 
+// Button event flag marking a release rather than a press.
+#define BUTTON_RELEASED 0x80
+
+// Depth of the button event queue.  Must be a power of two.
+#define BUTTONS_EVENTS  16
+
 // Button functions.
 uint8_t buttons_get(void);
+uint8_t buttons_changes_get(void);
+uint8_t buttons_events_pending(void);
+uint8_t buttons_event_get(uint16_t *time);
 
 #endif // _RB2_BUTTONS_H_
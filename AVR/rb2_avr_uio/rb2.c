@@ -217,6 +217,119 @@ static void rb2_reset_leds(void)
 }
 
 
+static uint8_t rb2_recv_bytes(uint8_t *buffer, uint8_t count)
+// Receive the indicated number of data bytes.  Returns zero if
+// the transfer was interrupted by an address.
+{
+    uint8_t i;
+    uint16_t data;
+
+    for (i = 0; i < count; ++i)
+    {
+        // Wait for serial data.
+        data = rb2_recv_data();
+
+        // Stop on error.
+        if (data == (uint16_t) -1) return 0;
+
+        // Save the data byte.
+        buffer[i] = (uint8_t) data;
+    }
+
+    return 1;
+}
+
+
+static void rb2_xmit_word(int16_t data)
+// Send a 16 bit word high byte first.
+{
+    rb2_xmit_data(((uint16_t) data >> 8) & 0xff);
+    rb2_xmit_data((uint16_t) data & 0xff);
+}
+
+
+static void rb2_changes_read(void)
+//  Handle the changes read command.  The button change count and the
+//  receiver frame sequence are sent as the response so the master can
+//  tell if anything changed with a short transaction.
+{
+    static receiver_frame frame;
+
+    // Get the current receiver frame.
+    receiver_frame_get(&frame);
+
+    // Send the change count and frame sequence.
+    rb2_xmit_data(buttons_changes_get());
+    rb2_xmit_data(frame.sequence);
+}
+
+
+static void rb2_events_read(void)
+//  Handle the button events read command.  The number of queued events is
+//  sent followed by the event code and the time of each event in
+//  milliseconds high byte first.
+{
+    uint8_t count;
+    uint8_t event;
+    uint16_t time;
+
+    // Send the number of events.
+    count = buttons_events_pending();
+    rb2_xmit_data(count);
+
+    // Send each event.
+    while (count--)
+    {
+        event = buttons_event_get(&time);
+        rb2_xmit_data(event);
+        rb2_xmit_word((int16_t) time);
+    }
+}
+
+
+static void rb2_status_exchange(uint8_t wide)
+//  Handle the status exchange commands.  The LEDs to be on and the LEDs
+//  to be blinking are received and all other LEDs are reset.  The next
+//  button followed by all six receiver channels of a single frame is sent
+//  as the response.  The wide exchange sends the button change count in
+//  place of the button so the master need not poll it separately,
+//  followed by the frame sequence, the frame time and the full 16 bit
+//  channels high byte first.
+{
+    uint8_t i;
+    uint8_t buffer[2];
+    static receiver_frame frame;
+
+    // Receive the LED state.
+    if (rb2_recv_bytes(buffer, sizeof(buffer)))
+    {
+        // Update the LEDs.
+        leds_set(buffer[0]);
+        leds_blink(buffer[1]);
+        leds_reset(~(buffer[0] | buffer[1]));
+
+        // Send the button change count or the next button.
+        rb2_xmit_data(wide ? buttons_changes_get() : (uint16_t) buttons_get());
+
+        // Get the current receiver frame.
+        receiver_frame_get(&frame);
+
+        if (wide)
+        {
+            // Send the frame sequence, time and channels.
+            rb2_xmit_data(frame.sequence);
+            rb2_xmit_word((int16_t) frame.time);
+            for (i = 0; i < RECEIVER_CHANNELS; ++i) rb2_xmit_word(frame.channels[i]);
+        }
+        else
+        {
+            // Send the channels scaled to 8 bits.
+            for (i = 0; i < RECEIVER_CHANNELS; ++i) rb2_xmit_data((uint8_t) (frame.channels[i] / 8));
+        }
+    }
+}
+
+
 NAKEDFUNC(rb2_task)
 // Task to process the RoboBricks2 protocol.
 {
@@ -320,6 +433,26 @@ NAKEDFUNC(rb2_task)
                     // Send the channel position.
                     rb2_xmit_data(result);
                 }
+                else if (data == 0x0b)
+                {
+                    // We received STATUS EXCHANGE command.
+                    rb2_status_exchange(0);
+                }
+                else if (data == 0x0c)
+                {
+                    // We received WIDE STATUS EXCHANGE command.
+                    rb2_status_exchange(1);
+                }
+                else if (data == 0x0d)
+                {
+                    // We received CHANGES READ command.
+                    rb2_changes_read();
+                }
+                else if (data == 0x0e)
+                {
+                    // We received BUTTON EVENTS READ command.
+                    rb2_events_read();
+                }
                 else if (data == 0xff)
                 {
                     // We are being deselected.
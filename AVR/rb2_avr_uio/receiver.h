@@ -27,6 +27,27 @@
 #ifndef _RB2_RECEIVER_H_
 #define _RB2_RECEIVER_H_ 1
 
+// Number of channels in a receiver frame.
+#define RECEIVER_CHANNELS   6
+
+// Channel values are the pulse duration from center in timer ticks of
+// 0.4 uS limited to +/- RECEIVER_RANGE.  This is 8 times the resolution
+// of the 8 bit channel values.
+#define RECEIVER_RANGE      1016
+
+// The frame time counts timer ticks shifted right by this amount so
+// each count is 3.2 uS and the time wraps about every 210 mS.
+#define RECEIVER_TIME_SHIFT 3
+
+// A receiver frame.  The sequence increments with each new frame.
+typedef struct
+{
+    uint8_t sequence;
+    uint16_t time;
+    int16_t channels[RECEIVER_CHANNELS];
+} receiver_frame;
+
 int8_t receiver_read(uint8_t channel);
+void receiver_frame_get(receiver_frame *frame);
 
 #endif // _RB2_RECEIVER_H_
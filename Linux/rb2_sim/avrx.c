@@ -0,0 +1,99 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Host shim of the AvrX kernel calls used by the robot control modules.
+    The simulation runs the control modules from a single thread so the
+    semaphores and timers reduce to simple flags that never block.
+*/
+
+#include "avrx.h"
+
+void AvrXSetSemaphore(pMutex m)
+{
+    *m = SEM_DONE;
+}
+
+
+void AvrXWaitSemaphore(pMutex m)
+{
+    *m = SEM_PEND;
+}
+
+
+Mutex AvrXTestSemaphore(pMutex m)
+{
+    return *m;
+}
+
+
+void AvrXSetObjectSemaphore(pMutex m)
+{
+    *m = SEM_DONE;
+}
+
+
+void AvrXWaitObjectSemaphore(pMutex m)
+{
+    *m = SEM_PEND;
+}
+
+
+Mutex AvrXTestObjectSemaphore(pMutex m)
+{
+    return *m;
+}
+
+
+void AvrXStartTimer(TimerControlBlock *t, uint16_t count)
+{
+    t->count = count;
+    t->semaphore = SEM_PEND;
+}
+
+
+void AvrXWaitTimer(TimerControlBlock *t)
+{
+    t->semaphore = SEM_DONE;
+}
+
+
+TimerControlBlock *AvrXCancelTimer(TimerControlBlock *t)
+{
+    (void) t;
+    return 0;
+}
+
+
+void AvrXDelay(TimerControlBlock *t, uint16_t count)
+{
+    (void) t;
+    (void) count;
+}
+
+
+pProcessID AvrXSelf(void)
+{
+    return NOPID;
+}
@@ -0,0 +1,402 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Host shim of the RoboBricks2 bus.  This replaces usart.c in the host
+    build and emulates the bus modules the control modules talk to: the
+    IMU (0x40), the Shaft2-D encoder (0x05), the MidiMotor2 motor driver
+    (0x50) and the user I/O module (0x30).  Each word transmitted by the
+    master is echoed into the receive queue followed by any response from
+    the selected module, just as on the half duplex bus.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "avrx.h"
+#include "bus.h"
+#include "usart.h"
+
+// Bus module addresses.
+#define BUS_ENCODER             0x05
+#define BUS_UIO                 0x30
+#define BUS_IMU                 0x40
+#define BUS_MOTOR               0x50
+
+// Size of the receive queue.
+#define BUS_QUEUE_SIZE          32
+
+// Plant being controlled.
+static const plant_params *bus_params;
+static plant_state *bus_state;
+
+// Receive queue.
+static uint16_t bus_queue[BUS_QUEUE_SIZE];
+static uint8_t bus_queue_head;
+static uint8_t bus_queue_tail;
+static uint8_t bus_timed_out;
+
+// Currently selected module.
+static uint8_t bus_selected;
+
+// IMU module state.
+static double bus_imu_noise;
+static int16_t bus_imu_angle;
+static int16_t bus_imu_rate;
+
+// Encoder module state.
+static int16_t bus_encoder_offset[2];
+static int16_t bus_encoder_latched[2];
+static uint8_t bus_encoder_wheel;
+
+// Motor module state.
+static uint8_t bus_motor_select;
+static int8_t bus_motor_speed[2];
+
+// User I/O module state.
+static uint8_t bus_uio_data_pending;
+static uint8_t bus_uio_exchange_pending;
+static uint8_t bus_uio_exchange_wide;
+static uint8_t bus_rc_sequence;
+static int8_t bus_rc_chan1;
+static int8_t bus_rc_chan2;
+
+static void bus_reply(uint16_t data)
+// Place a word in the receive queue.
+{
+    bus_queue[bus_queue_tail] = data;
+    bus_queue_tail = (bus_queue_tail + 1) % BUS_QUEUE_SIZE;
+}
+
+
+static double bus_noise(void)
+// Approximately normal noise with unit standard deviation.
+{
+    double sum = 0.0;
+    uint8_t i;
+
+    for (i = 0; i < 12; ++i) sum += (double) rand() / RAND_MAX;
+
+    return sum - 6.0;
+}
+
+
+static int16_t bus_encoder_count(uint8_t wheel)
+// Get the raw encoder count as seen by the Shaft2-D module.  The left
+// encoder counts backwards as the wheels are geometrically opposed.
+{
+    int16_t count = plant_encoder_get(bus_params, bus_state, wheel);
+
+    if (wheel == PLANT_LEFT) count = -count;
+
+    return count - bus_encoder_offset[wheel];
+}
+
+
+static void bus_imu_latch(void)
+// Latch the IMU pitch values as 8:8 fixed point degrees.
+{
+    double angle;
+    double rate;
+
+    angle = bus_state->pitch * 180.0 / M_PI + bus_imu_noise * bus_noise();
+    rate = bus_state->pitch_rate * 180.0 / M_PI;
+
+    bus_imu_angle = (int16_t) lrint(angle * 256.0);
+    bus_imu_rate = (int16_t) lrint(rate * 256.0);
+}
+
+
+static void bus_imu_command(uint8_t command)
+// Handle a command to the IMU module.
+{
+    if (command == 0x00)
+    {
+        bus_imu_latch();
+        bus_reply(0x00A5);
+    }
+    else if (command == 0x01) bus_reply((uint16_t) bus_imu_angle >> 8);
+    else if (command == 0x02) bus_reply((uint16_t) bus_imu_angle & 0xff);
+    else if (command == 0x03) bus_reply((uint16_t) bus_imu_rate >> 8);
+    else if (command == 0x04) bus_reply((uint16_t) bus_imu_rate & 0xff);
+    else if ((command >= 0x05) && (command <= 0x0a)) bus_reply(0x0000);
+    else if (command == 0x0b)
+    {
+        bus_imu_latch();
+        bus_reply((uint16_t) bus_imu_angle >> 8);
+        bus_reply((uint16_t) bus_imu_angle & 0xff);
+        bus_reply((uint16_t) bus_imu_rate >> 8);
+        bus_reply((uint16_t) bus_imu_rate & 0xff);
+    }
+    else if (command == 0x0c)
+    {
+        // The raw sensor values are not modeled.
+        uint8_t i;
+        for (i = 0; i < 6; ++i) bus_reply(0x0000);
+    }
+}
+
+
+static void bus_encoder_command(uint8_t command)
+// Handle a command to the Shaft2-D encoder module.
+{
+    uint8_t i;
+
+    if (command == 0x00)
+    {
+        // Latch both shafts.
+        for (i = 0; i < 2; ++i) bus_encoder_latched[i] = bus_encoder_count(i);
+    }
+    else if (command == 0x01)
+    {
+        // Clear both shafts.
+        for (i = 0; i < 2; ++i) bus_encoder_offset[i] += bus_encoder_count(i);
+    }
+    else if ((command == 0x02) || (command == 0x03))
+    {
+        // Send the high byte and select the low byte of the shaft.
+        bus_encoder_wheel = command == 0x02 ? PLANT_LEFT : PLANT_RIGHT;
+        bus_reply(((uint16_t) bus_encoder_latched[bus_encoder_wheel] >> 8) & 0xff);
+    }
+    else if (command == 0x04)
+    {
+        // Send the low byte of the selected shaft.
+        bus_reply((uint16_t) bus_encoder_latched[bus_encoder_wheel] & 0xff);
+    }
+}
+
+
+static void bus_motor_command(uint8_t command)
+// Handle a command to the MidiMotor2 module.  Motor 1 drives the right
+// wheel and motor 2 drives the left wheel, both reversed.
+{
+    if (bus_motor_select)
+    {
+        // This is the speed for the selected motor.
+        bus_motor_speed[bus_motor_select == 0x01 ? PLANT_RIGHT : PLANT_LEFT] = (int8_t) -(int8_t) command;
+        bus_motor_select = 0;
+
+        // Apply the speeds to the plant.
+        plant_pwm_set(bus_params, bus_state, bus_motor_speed[PLANT_LEFT], bus_motor_speed[PLANT_RIGHT]);
+    }
+    else if ((command == 0x01) || (command == 0x03))
+    {
+        // Select the motor speed to set.
+        bus_motor_select = command;
+    }
+}
+
+
+static void bus_uio_reply_word(int16_t data)
+// Place a 16 bit word in the receive queue high byte first.
+{
+    bus_reply(((uint16_t) data >> 8) & 0xff);
+    bus_reply((uint16_t) data & 0xff);
+}
+
+
+static void bus_uio_command(uint8_t command)
+// Handle a command to the user I/O module.
+{
+    if (bus_uio_exchange_pending)
+    {
+        // The LED state is ignored and once both bytes are received the
+        // button, or the button change count of the wide exchange, and
+        // the receiver channels are sent.  No button is ever pressed.
+        if (--bus_uio_exchange_pending == 0)
+        {
+            uint8_t i;
+            bus_reply(0x0000);
+            if (bus_uio_exchange_wide)
+            {
+                // A new receiver frame is reported with every exchange.
+                // The frame time is not modeled.
+                bus_reply(++bus_rc_sequence);
+                bus_uio_reply_word(0x0000);
+                bus_uio_reply_word(bus_rc_chan1 * 8);
+                bus_uio_reply_word(bus_rc_chan2 * 8);
+                for (i = 2; i < 6; ++i) bus_uio_reply_word(0x0000);
+            }
+            else
+            {
+                bus_reply((uint8_t) bus_rc_chan1);
+                bus_reply((uint8_t) bus_rc_chan2);
+                for (i = 2; i < 6; ++i) bus_reply(0x0000);
+            }
+        }
+    }
+    else if (bus_uio_data_pending)
+    {
+        // The LED data is acknowledged and ignored.
+        bus_uio_data_pending = 0;
+        bus_reply(0x00A5);
+    }
+    else if ((command >= 0x01) && (command <= 0x03))
+    {
+        // LED command followed by the LED data.
+        bus_uio_data_pending = 1;
+        bus_reply(0x00A5);
+    }
+    else if (command == 0x04) bus_reply(0x0000);
+    else if (command == 0x05) bus_reply((uint8_t) bus_rc_chan1);
+    else if (command == 0x06) bus_reply((uint8_t) bus_rc_chan2);
+    else if (command == 0x0d)
+    {
+        // No button changes and a new receiver frame with every poll.
+        bus_reply(0x0000);
+        bus_reply((uint8_t) (bus_rc_sequence + 1));
+    }
+    else if (command == 0x0e) bus_reply(0x0000);
+    else if ((command == 0x0b) || (command == 0x0c))
+    {
+        // Status exchange with the LED state to follow.
+        bus_uio_exchange_pending = 2;
+        bus_uio_exchange_wide = command == 0x0c;
+    }
+}
+
+
+void bus_init(const plant_params *params, plant_state *state)
+// Attach the bus modules to the plant.
+{
+    bus_params = params;
+    bus_state = state;
+}
+
+
+void bus_imu_noise_set(double noise)
+// Set the standard deviation of the IMU angle noise in degrees.
+{
+    bus_imu_noise = noise;
+}
+
+
+void bus_rc_set(int8_t chan1, int8_t chan2)
+// Set the RC channel values reported by the user I/O module.
+{
+    bus_rc_chan1 = chan1;
+    bus_rc_chan2 = chan2;
+}
+
+
+void bus_pwm_get(int8_t *left_pwm, int8_t *right_pwm)
+// Get the PWM values last received by the motor module.
+{
+    if (left_pwm) *left_pwm = bus_motor_speed[PLANT_LEFT];
+    if (right_pwm) *right_pwm = bus_motor_speed[PLANT_RIGHT];
+}
+
+
+void usart_init(void)
+// Reset the bus.
+{
+    bus_queue_head = bus_queue_tail = 0;
+    bus_selected = 0;
+}
+
+
+void usart_grab_access(void)
+// Grab access to the bus and flush the receive queue.
+{
+    bus_queue_head = bus_queue_tail;
+    bus_timed_out = 0;
+}
+
+
+uint8_t usart_timed_out_get(void)
+// Returns non-zero if a receive found no word since access was grabbed.
+{
+    return bus_timed_out;
+}
+
+
+void usart_release_access(void)
+// Release access to the bus.
+{
+}
+
+
+void usart_xmit(uint16_t data)
+// Transmit a word to the bus modules.
+{
+    // Every word is echoed back to the master.
+    bus_reply(data);
+
+    // Is this an address?
+    if (data & 0x0100)
+    {
+        // Select the module and respond if it exists.
+        bus_selected = (uint8_t) data;
+        bus_motor_select = 0;
+        bus_uio_data_pending = 0;
+        bus_uio_exchange_pending = 0;
+        if ((bus_selected == BUS_ENCODER) || (bus_selected == BUS_UIO) ||
+            (bus_selected == BUS_IMU) || (bus_selected == BUS_MOTOR)) bus_reply(0x00A5);
+        return;
+    }
+
+    // Pass the command to the selected module.
+    switch (bus_selected)
+    {
+        case BUS_IMU: bus_imu_command((uint8_t) data); break;
+        case BUS_ENCODER: bus_encoder_command((uint8_t) data); break;
+        case BUS_MOTOR: bus_motor_command((uint8_t) data); break;
+        case BUS_UIO: bus_uio_command((uint8_t) data); break;
+    }
+}
+
+
+void usart_xmit_discard_echo(uint16_t data)
+// Transmit a word and discard the echo.
+{
+    usart_xmit(data);
+    usart_recv();
+}
+
+
+uint16_t usart_recv(void)
+// Receive the next word.  An empty queue reads as -1 like a receive that
+// missed its deadline on the robot, as does every receive after it until
+// access is grabbed again.
+{
+    uint16_t data;
+
+    if (bus_timed_out || (bus_queue_head == bus_queue_tail))
+    {
+        bus_timed_out = 1;
+        return (uint16_t) -1;
+    }
+
+    data = bus_queue[bus_queue_head];
+    bus_queue_head = (bus_queue_head + 1) % BUS_QUEUE_SIZE;
+
+    return data;
+}
+
+
+uint16_t usart_recv_default(void)
+// No words arrive outside of a master transaction.
+{
+    return 0x0000;
+}
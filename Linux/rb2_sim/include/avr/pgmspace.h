@@ -0,0 +1,47 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Host shim of the AVR program memory access.  Program memory is
+    ordinary memory on the host.
+*/
+
+#ifndef _RB2_SIM_AVR_PGMSPACE_H_
+#define _RB2_SIM_AVR_PGMSPACE_H_ 1
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define PGM_P                   const char *
+
+#define pgm_read_byte(p)        (*(const uint8_t *) (p))
+#define pgm_read_word(p)        (*(const uint16_t *) (p))
+#define pgm_read_dword(p)       (*(const uint32_t *) (p))
+#define pgm_read_byte_near(p)   pgm_read_byte(p)
+#define pgm_read_word_near(p)   pgm_read_word(p)
+#define memcpy_P                memcpy
+
+#endif // _RB2_SIM_AVR_PGMSPACE_H_
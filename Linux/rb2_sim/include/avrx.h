@@ -0,0 +1,67 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Host shim of the AvrX interface used by the robot control modules.
+*/
+
+#ifndef _RB2_SIM_AVRX_H_
+#define _RB2_SIM_AVRX_H_ 1
+
+#include <stdint.h>
+
+#define SEM_PEND                ((Mutex) 0)
+#define SEM_DONE                ((Mutex) 1)
+
+typedef uint8_t Mutex, *pMutex;
+
+typedef struct
+{
+    Mutex semaphore;
+    uint16_t count;
+} TimerControlBlock;
+
+typedef void *pProcessID;
+
+#define NOPID                   ((pProcessID) 0)
+#define INTERFACE
+#define NAKEDFUNC(A)            void A(void)
+#define AVRX_MUTEX(A)           Mutex A
+#define AVRX_TIMER(A)           TimerControlBlock A
+#define AVRX_GCC_TASK(A, B, C)  void A(void)
+
+INTERFACE void AvrXSetSemaphore(pMutex);
+INTERFACE void AvrXWaitSemaphore(pMutex);
+INTERFACE Mutex AvrXTestSemaphore(pMutex);
+INTERFACE void AvrXSetObjectSemaphore(pMutex);
+INTERFACE void AvrXWaitObjectSemaphore(pMutex);
+INTERFACE Mutex AvrXTestObjectSemaphore(pMutex);
+
+INTERFACE void AvrXStartTimer(TimerControlBlock *, uint16_t);
+INTERFACE void AvrXWaitTimer(TimerControlBlock *);
+INTERFACE TimerControlBlock *AvrXCancelTimer(TimerControlBlock *);
+INTERFACE void AvrXDelay(TimerControlBlock *, uint16_t);
+INTERFACE pProcessID AvrXSelf(void);
+
+#endif // _RB2_SIM_AVRX_H_
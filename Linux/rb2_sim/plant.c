@@ -0,0 +1,161 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Wheeled inverted pendulum plant model.  The two wheels share the body
+    pitch dynamics through their summed motor torque and the difference in
+    motor torque turns the robot.  Each motor is modeled as a DC motor with
+    back EMF and viscous friction acting between the body and the wheel.
+
+    The equations of motion with wheel angle phi and body pitch theta are:
+
+        a11 phi'' + a12 theta'' - M r l sin(theta) theta'^2 = tau
+        a12 phi'' + a22 theta'' - M g l sin(theta)          = -tau
+
+    where a11 = (2 m + M) r^2 + 2 Jw, a12 = M r l cos(theta) and
+    a22 = M l^2 + Jb.
+*/
+
+#include <math.h>
+#include <string.h>
+#include "plant.h"
+
+#define PLANT_GRAVITY           9.81
+
+void plant_params_default(plant_params *params)
+// Parameters approximating the RoboBricks2 balancing robot.
+{
+    params->body_mass = 1.5;
+    params->body_height = 0.20;
+    params->body_inertia = 1.5 * 0.20 * 0.20 / 3.0;
+    params->balance_angle = -0.5 * M_PI / 180.0;
+    params->wheel_mass = 0.03;
+    params->wheel_radius = 0.04;
+    params->wheel_inertia = 0.5 * 0.03 * 0.04 * 0.04 + 1.0e-3;
+    params->motor_kt = 0.24;
+    params->motor_ke = 0.24;
+    params->motor_r = 5.8;
+    params->motor_friction = 0.002;
+    params->supply_volts = 7.2;
+    params->encoder_cpr = 4000.0;
+    params->fall_angle = 60.0 * M_PI / 180.0;
+}
+
+
+void plant_reset(plant_state *state, double pitch)
+// Reset the plant to rest at the indicated pitch.
+{
+    memset(state, 0, sizeof(plant_state));
+    state->pitch = pitch;
+}
+
+
+static double plant_motor_torque(const plant_params *params, const plant_state *state, uint8_t wheel)
+// Torque applied by the motor between the body and the wheel.
+{
+    double omega;
+    double current;
+
+    // The motor turns with the wheel relative to the body.
+    omega = state->wheel_rate[wheel] - state->pitch_rate;
+
+    // Motor current from the applied voltage less the back EMF.
+    current = (state->volts[wheel] - params->motor_ke * omega) / params->motor_r;
+
+    return params->motor_kt * current - params->motor_friction * omega;
+}
+
+
+void plant_step(const plant_params *params, plant_state *state, double dt)
+// Advance the plant by dt seconds with semi-implicit Euler integration.
+{
+    double m = params->wheel_mass;
+    double M = params->body_mass;
+    double r = params->wheel_radius;
+    double l = params->body_height;
+    double a11, a12, a22, det;
+    double b1, b2;
+    double tau_left, tau_right;
+    double phi_acc, diff_acc, pitch_acc;
+    double theta;
+    uint8_t i;
+
+    // Nothing moves once fallen.
+    if (state->fallen) return;
+
+    // Pitch relative to the balance point of the center of mass.
+    theta = state->pitch - params->balance_angle;
+
+    // Motor torques.
+    tau_left = plant_motor_torque(params, state, PLANT_LEFT);
+    tau_right = plant_motor_torque(params, state, PLANT_RIGHT);
+
+    // Mass matrix.
+    a11 = (2.0 * m + M) * r * r + 2.0 * params->wheel_inertia;
+    a12 = M * r * l * cos(theta);
+    a22 = M * l * l + params->body_inertia;
+
+    // Generalized forces.
+    b1 = tau_left + tau_right + M * r * l * sin(theta) * state->pitch_rate * state->pitch_rate;
+    b2 = -(tau_left + tau_right) + M * PLANT_GRAVITY * l * sin(theta);
+
+    // Solve for the mean wheel and pitch accelerations.
+    det = a11 * a22 - a12 * a12;
+    phi_acc = (b1 * a22 - b2 * a12) / det;
+    pitch_acc = (a11 * b2 - a12 * b1) / det;
+
+    // The torque difference turns the robot.
+    diff_acc = (tau_right - tau_left) / a11;
+
+    // Integrate the velocities and then the positions.
+    state->pitch_rate += pitch_acc * dt;
+    state->wheel_rate[PLANT_LEFT] += (phi_acc - diff_acc) * dt;
+    state->wheel_rate[PLANT_RIGHT] += (phi_acc + diff_acc) * dt;
+    state->pitch += state->pitch_rate * dt;
+    for (i = 0; i < 2; ++i) state->wheel[i] += state->wheel_rate[i] * dt;
+    state->time += dt;
+
+    // Has the robot fallen over?
+    if (fabs(state->pitch) > params->fall_angle) state->fallen = 1;
+}
+
+
+void plant_pwm_set(const plant_params *params, plant_state *state, int8_t left_pwm, int8_t right_pwm)
+// Apply the motor PWM values as average voltages.
+{
+    state->volts[PLANT_LEFT] = params->supply_volts * left_pwm / 127.0;
+    state->volts[PLANT_RIGHT] = params->supply_volts * right_pwm / 127.0;
+}
+
+
+int16_t plant_encoder_get(const plant_params *params, const plant_state *state, uint8_t wheel)
+// Get the 16 bit encoder count of the motor shaft relative to the body.
+{
+    double counts;
+
+    // The encoder is mounted on the body and measures the relative angle.
+    counts = (state->wheel[wheel] - state->pitch) * params->encoder_cpr / (2.0 * M_PI);
+
+    return (int16_t) (int32_t) floor(counts);
+}
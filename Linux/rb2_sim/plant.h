@@ -0,0 +1,70 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_SIM_PLANT_H_
+#define _RB2_SIM_PLANT_H_ 1
+
+#include <stdint.h>
+
+#define PLANT_LEFT              0
+#define PLANT_RIGHT             1
+
+typedef struct
+{
+    double body_mass;           // Body mass above the axle in kg.
+    double body_height;         // Height of the body center of mass above the axle in m.
+    double body_inertia;        // Body inertia about its center of mass in kg m^2.
+    double balance_angle;       // Pitch at which the center of mass is over the axle in rad.
+    double wheel_mass;          // Mass of each wheel in kg.
+    double wheel_radius;        // Wheel radius in m.
+    double wheel_inertia;       // Inertia of each wheel and gear train in kg m^2.
+    double motor_kt;            // Motor torque constant at the wheel in N m/A.
+    double motor_ke;            // Motor back EMF constant at the wheel in V s/rad.
+    double motor_r;             // Motor winding resistance in ohm.
+    double motor_friction;      // Viscous friction of the gear train in N m s/rad.
+    double supply_volts;        // Motor supply voltage at full PWM.
+    double encoder_cpr;         // Encoder counts per wheel revolution.
+    double fall_angle;          // Pitch at which the robot has fallen in rad.
+} plant_params;
+
+typedef struct
+{
+    double time;                // Simulated time in s.
+    double pitch;               // Body pitch in rad, positive leaning forward.
+    double pitch_rate;          // Body pitch rate in rad/s.
+    double wheel[2];            // Wheel angles in rad, positive rolling forward.
+    double wheel_rate[2];       // Wheel rates in rad/s.
+    double volts[2];            // Applied motor voltages.
+    int fallen;                 // Set once the robot has fallen.
+} plant_state;
+
+void plant_params_default(plant_params *params);
+void plant_reset(plant_state *state, double pitch);
+void plant_step(const plant_params *params, plant_state *state, double dt);
+void plant_pwm_set(const plant_params *params, plant_state *state, int8_t left_pwm, int8_t right_pwm);
+int16_t plant_encoder_get(const plant_params *params, const plant_state *state, uint8_t wheel);
+
+#endif // _RB2_SIM_PLANT_H_
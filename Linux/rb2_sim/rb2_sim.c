@@ -0,0 +1,136 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Command line front end of the closed loop robot simulation.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "balance.h"
+#include "sim.h"
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -t seconds     simulated time (default 10)\n"
+        "  -a degrees     initial pitch disturbance (default 5)\n"
+        "  -n degrees     IMU angle noise standard deviation (default 0)\n"
+        "  -s value       RC speed step value (default 0)\n"
+        "  -h value       RC heading step value (default 0)\n"
+        "  -S seconds     time of the RC step (default 5)\n"
+        "  -b p,d,i,t     balance gains and tilt compensation as 8:8 fixed point\n"
+        "  -m p,d,i       motor gains as 8:8 fixed point\n"
+        "  -f             use the state feedback balance controller\n"
+        "  -k a,r,p,v     state feedback gains as 8:8 fixed point\n"
+        "  -o file        write a CSV log of each control tick\n",
+        name);
+    exit(1);
+}
+
+
+int main(int argc, char **argv)
+{
+    int opt;
+    int p, d, i, t;
+    double elapsed;
+    struct timespec start;
+    struct timespec stop;
+    sim_config config;
+    sim_result result;
+
+    sim_config_default(&config);
+
+    while ((opt = getopt(argc, argv, "t:a:n:s:h:S:b:m:fk:o:")) != -1)
+    {
+        switch (opt)
+        {
+            case 't': config.duration = atof(optarg); break;
+            case 'a': config.initial_pitch = atof(optarg); break;
+            case 'n': config.imu_noise = atof(optarg); break;
+            case 's': config.speed_rc = (int8_t) atoi(optarg); break;
+            case 'h': config.heading_rc = (int8_t) atoi(optarg); break;
+            case 'S': config.step_time = atof(optarg); break;
+            case 'b':
+                if (sscanf(optarg, "%i,%i,%i,%i", &p, &d, &i, &t) != 4) usage(argv[0]);
+                config.set_balance_gains = 1;
+                config.balance_p_gain = (int16_t) p;
+                config.balance_d_gain = (int16_t) d;
+                config.balance_i_gain = (int16_t) i;
+                config.balance_t_comp = (int16_t) t;
+                break;
+            case 'm':
+                if (sscanf(optarg, "%i,%i,%i", &p, &d, &i) != 3) usage(argv[0]);
+                config.set_motor_gains = 1;
+                config.motor_p_gain = (int16_t) p;
+                config.motor_d_gain = (int16_t) d;
+                config.motor_i_gain = (int16_t) i;
+                break;
+            case 'f':
+                config.balance_mode = BALANCE_MODE_STATEFB;
+                break;
+            case 'k':
+                if (sscanf(optarg, "%i,%i,%i,%i", &p, &d, &i, &t) != 4) usage(argv[0]);
+                config.set_statefb_gains = 1;
+                config.statefb_angle_gain = (int16_t) p;
+                config.statefb_rate_gain = (int16_t) d;
+                config.statefb_position_gain = (int16_t) i;
+                config.statefb_velocity_gain = (int16_t) t;
+                break;
+            case 'o':
+                config.log = fopen(optarg, "w");
+                if (!config.log) { perror(optarg); return 1; }
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    // Run the simulation.
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    sim_run(&config, &result);
+    clock_gettime(CLOCK_MONOTONIC, &stop);
+    elapsed = (stop.tv_sec - start.tv_sec) + (stop.tv_nsec - start.tv_nsec) * 1e-9;
+
+    if (config.log) fclose(config.log);
+
+    // Report the results.
+    printf("fell:        %s", result.fell ? "yes" : "no");
+    if (result.fell) printf(" at %.2f s", result.fall_time);
+    printf("\n");
+    printf("settle time: %.3f s\n", result.settle_time);
+    printf("overshoot:   %.2f deg\n", result.overshoot);
+    printf("max pitch:   %.2f deg\n", result.max_pitch);
+    printf("saturation:  %.1f %%\n", result.saturation * 100.0);
+    printf("distance:    %.3f m\n", result.distance);
+    printf("odometry x:  %.3f m\n", result.odometry_x);
+    printf("simulated:   %.2f s in %.4f s (%.0fx real time)\n", result.time, elapsed,
+           elapsed > 0.0 ? result.time / elapsed : 0.0);
+
+    return result.fell ? 2 : 0;
+}
@@ -0,0 +1,470 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Parallel gain sweep of the balance and motor gains using the closed
+    loop simulation.  Each candidate gain set is run against a set of
+    scenarios and ranked by settling time, overshoot and motor saturation.
+
+    The control modules keep their state in file scope statics, so each
+    simulation runs in its own forked process rather than a thread.  Up to
+    one process per core runs at a time and the results are returned
+    through shared memory.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "config.h"
+#include "balance.h"
+#include "motor.h"
+#include "sim.h"
+
+// Swept gains.
+#define GAIN_BALANCE_P          0
+#define GAIN_BALANCE_D          1
+#define GAIN_BALANCE_I          2
+#define GAIN_BALANCE_T          3
+#define GAIN_MOTOR_P            4
+#define GAIN_MOTOR_D            5
+#define GAIN_MOTOR_I            6
+#define GAIN_COUNT              7
+
+// Limit on the candidates in a sweep.
+#define TUNE_MAX_CANDIDATES     1000000
+
+// Cost weights.
+#define COST_FALL               1000.0
+#define COST_OVERSHOOT          0.2
+#define COST_SATURATION         5.0
+
+typedef struct
+{
+    double lo;
+    double hi;
+    double step;
+} gain_range;
+
+typedef struct
+{
+    int16_t gain[GAIN_COUNT];
+    int fell;
+    double settle_time;
+    double overshoot;
+    double saturation;
+    double cost;
+} candidate;
+
+typedef struct
+{
+    double initial_pitch;
+    double imu_noise;
+} scenario;
+
+// Scenarios each candidate must handle.
+static const scenario tune_scenarios[] =
+{
+    // Pitch    Noise
+    { 5.0,      0.0 },
+    { -8.0,     0.0 },
+    { 12.0,     0.0 },
+    { 3.0,      0.2 },
+};
+
+#define SCENARIO_COUNT      (sizeof(tune_scenarios) / sizeof(scenario))
+
+static gain_range tune_ranges[GAIN_COUNT];
+static double tune_duration = 10.0;
+static int tune_jobs;
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -p lo:hi:step  balance p gain range\n"
+        "  -d lo:hi:step  balance d gain range\n"
+        "  -i lo:hi:step  balance i gain range (as tuned at 20 ms in balance.c)\n"
+        "  -c lo:hi:step  balance tilt compensation range\n"
+        "  -P lo:hi:step  motor p gain range\n"
+        "  -D lo:hi:step  motor d gain range\n"
+        "  -I lo:hi:step  motor i gain range\n"
+        "  -t seconds     simulated time of each scenario (default 10)\n"
+        "  -r rounds      refinement rounds around the best candidate (default 2)\n"
+        "  -n count       number of ranked candidates to print (default 10)\n"
+        "  -j jobs        parallel simulations (default one per core)\n"
+        "Gains are given as real values and converted to 8:8 fixed point.\n"
+        "A gain that is not swept keeps its firmware default.\n",
+        name);
+    exit(1);
+}
+
+
+static void range_parse(const char *arg, gain_range *range, const char *name)
+// Parse a lo:hi:step range or a single value.
+{
+    int n = sscanf(arg, "%lf:%lf:%lf", &range->lo, &range->hi, &range->step);
+
+    if (n == 1)
+    {
+        range->hi = range->lo;
+        range->step = 1.0;
+    }
+    else if ((n != 3) || (range->step <= 0.0) || (range->hi < range->lo)) usage(name);
+}
+
+
+static int16_t gain_to_fixed(uint8_t gain, double value)
+// Convert a real gain to the 8:8 fixed point value used by the firmware.
+// The balance i gain and motor d and i gains are scaled to the control
+// period the same way as in balance.c and motor.c.
+{
+    if (gain == GAIN_BALANCE_I) value = value * CONTROL_PERIOD / 20.0;
+    if (gain == GAIN_MOTOR_D) value = value * 10.0 / CONTROL_PERIOD;
+    if (gain == GAIN_MOTOR_I) value = value * CONTROL_PERIOD / 10.0;
+
+    // Limit to the 8:8 range.
+    value = value * 256.0;
+    if (value > 32767.0) value = 32767.0;
+    if (value < -32768.0) value = -32768.0;
+
+    return (int16_t) lrint(value);
+}
+
+
+static double gain_from_fixed(uint8_t gain, int16_t fixed)
+// Convert a firmware 8:8 fixed point value back to a real gain.
+{
+    double value = fixed / 256.0;
+
+    if (gain == GAIN_BALANCE_I) value = value * 20.0 / CONTROL_PERIOD;
+    if (gain == GAIN_MOTOR_D) value = value * CONTROL_PERIOD / 10.0;
+    if (gain == GAIN_MOTOR_I) value = value * 10.0 / CONTROL_PERIOD;
+
+    return value;
+}
+
+
+static uint32_t range_count(const gain_range *range)
+// Number of values in the range.  An unset range has no values.
+{
+    if (range->step <= 0.0) return 0;
+
+    return (uint32_t) floor((range->hi - range->lo) / range->step + 1e-9) + 1;
+}
+
+
+static void default_gains(int16_t *gains)
+// Get the firmware default gains from a simulation run.
+{
+    // A zero length run initializes the control modules with their
+    // defaults without overriding them.
+    sim_config config;
+    sim_result result;
+    int16_t *shared;
+    pid_t pid;
+
+    shared = mmap(NULL, sizeof(int16_t) * GAIN_COUNT, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (shared == MAP_FAILED) { perror("mmap"); exit(1); }
+
+    pid = fork();
+    if (pid == 0)
+    {
+        sim_config_default(&config);
+        config.duration = 0.0;
+        sim_run(&config, &result);
+        balance_gains_get(&shared[GAIN_BALANCE_P], &shared[GAIN_BALANCE_D], &shared[GAIN_BALANCE_I], &shared[GAIN_BALANCE_T]);
+        motor_left_gains_get(&shared[GAIN_MOTOR_P], &shared[GAIN_MOTOR_D], &shared[GAIN_MOTOR_I]);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+
+    memcpy(gains, shared, sizeof(int16_t) * GAIN_COUNT);
+    munmap(shared, sizeof(int16_t) * GAIN_COUNT);
+}
+
+
+static void run_candidates(candidate *candidates, uint32_t count)
+// Run every candidate against every scenario in parallel processes.
+{
+    uint32_t jobs = count * SCENARIO_COUNT;
+    uint32_t next = 0;
+    uint32_t running = 0;
+    uint32_t i;
+    sim_result *results;
+    sim_config config;
+    const scenario *s;
+    const candidate *c;
+    int status;
+
+    // Shared result for each job.  A job that dies is treated as a fall.
+    results = mmap(NULL, sizeof(sim_result) * jobs, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED) { perror("mmap"); exit(1); }
+    for (i = 0; i < jobs; ++i) results[i].fell = 1;
+
+    while ((next < jobs) || running)
+    {
+        // Start jobs until each core is busy.
+        while ((next < jobs) && (running < (uint32_t) tune_jobs))
+        {
+            pid_t pid = fork();
+
+            if (pid < 0) { perror("fork"); exit(1); }
+            if (pid == 0)
+            {
+                c = &candidates[next / SCENARIO_COUNT];
+                s = &tune_scenarios[next % SCENARIO_COUNT];
+
+                // Configure the scenario and candidate gains.
+                sim_config_default(&config);
+                config.duration = tune_duration;
+                config.initial_pitch = s->initial_pitch;
+                config.imu_noise = s->imu_noise;
+                config.set_balance_gains = 1;
+                config.balance_p_gain = c->gain[GAIN_BALANCE_P];
+                config.balance_d_gain = c->gain[GAIN_BALANCE_D];
+                config.balance_i_gain = c->gain[GAIN_BALANCE_I];
+                config.balance_t_comp = c->gain[GAIN_BALANCE_T];
+                config.set_motor_gains = 1;
+                config.motor_p_gain = c->gain[GAIN_MOTOR_P];
+                config.motor_d_gain = c->gain[GAIN_MOTOR_D];
+                config.motor_i_gain = c->gain[GAIN_MOTOR_I];
+
+                sim_run(&config, &results[next]);
+                _exit(0);
+            }
+
+            ++next;
+            ++running;
+        }
+
+        // Wait for a job to finish.
+        if (wait(&status) > 0) --running;
+    }
+
+    // Combine the scenario results of each candidate using the worst case.
+    for (i = 0; i < count; ++i)
+    {
+        candidate *cand = &candidates[i];
+        uint32_t j;
+
+        cand->fell = 0;
+        cand->settle_time = 0.0;
+        cand->overshoot = 0.0;
+        cand->saturation = 0.0;
+        for (j = 0; j < SCENARIO_COUNT; ++j)
+        {
+            const sim_result *r = &results[i * SCENARIO_COUNT + j];
+
+            if (r->fell) ++cand->fell;
+            if (r->settle_time > cand->settle_time) cand->settle_time = r->settle_time;
+            if (r->overshoot > cand->overshoot) cand->overshoot = r->overshoot;
+            if (r->saturation > cand->saturation) cand->saturation = r->saturation;
+        }
+
+        cand->cost = COST_FALL * cand->fell + cand->settle_time +
+                     COST_OVERSHOOT * cand->overshoot + COST_SATURATION * cand->saturation;
+    }
+
+    munmap(results, sizeof(sim_result) * jobs);
+}
+
+
+static int candidate_compare(const void *a, const void *b)
+{
+    double ca = ((const candidate *) a)->cost;
+    double cb = ((const candidate *) b)->cost;
+
+    return (ca > cb) - (ca < cb);
+}
+
+
+static uint32_t grid_build(candidate **out, const gain_range *ranges, const int16_t *defaults)
+// Build the candidates for every combination of the ranges.
+{
+    uint32_t counts[GAIN_COUNT];
+    uint32_t total = 1;
+    uint32_t i;
+    uint8_t g;
+    candidate *candidates;
+
+    for (g = 0; g < GAIN_COUNT; ++g)
+    {
+        counts[g] = range_count(&ranges[g]);
+        if (counts[g] == 0) counts[g] = 1;
+        if (total > TUNE_MAX_CANDIDATES / counts[g])
+        {
+            fprintf(stderr, "too many candidates, limit is %u\n", TUNE_MAX_CANDIDATES);
+            exit(1);
+        }
+        total *= counts[g];
+    }
+
+    candidates = calloc(total, sizeof(candidate));
+    if (!candidates) { perror("calloc"); exit(1); }
+
+    for (i = 0; i < total; ++i)
+    {
+        uint32_t index = i;
+
+        for (g = 0; g < GAIN_COUNT; ++g)
+        {
+            uint32_t k = index % counts[g];
+            index /= counts[g];
+
+            if (ranges[g].step > 0.0)
+                candidates[i].gain[g] = gain_to_fixed(g, ranges[g].lo + k * ranges[g].step);
+            else
+                candidates[i].gain[g] = defaults[g];
+        }
+    }
+
+    *out = candidates;
+
+    return total;
+}
+
+
+static void print_candidate(const candidate *c)
+{
+    printf("cost %8.3f  fell %d  settle %6.3f s  overshoot %5.2f deg  saturation %5.1f %%  "
+           "balance %.2f %.2f %.2f %.2f  motor 0x%04x 0x%04x 0x%04x\n",
+           c->cost, c->fell, c->settle_time, c->overshoot, c->saturation * 100.0,
+           gain_from_fixed(GAIN_BALANCE_P, c->gain[GAIN_BALANCE_P]),
+           gain_from_fixed(GAIN_BALANCE_D, c->gain[GAIN_BALANCE_D]),
+           gain_from_fixed(GAIN_BALANCE_I, c->gain[GAIN_BALANCE_I]),
+           gain_from_fixed(GAIN_BALANCE_T, c->gain[GAIN_BALANCE_T]),
+           (uint16_t) lrint(gain_from_fixed(GAIN_MOTOR_P, c->gain[GAIN_MOTOR_P]) * 256.0),
+           (uint16_t) lrint(gain_from_fixed(GAIN_MOTOR_D, c->gain[GAIN_MOTOR_D]) * 256.0),
+           (uint16_t) lrint(gain_from_fixed(GAIN_MOTOR_I, c->gain[GAIN_MOTOR_I]) * 256.0));
+}
+
+
+static void print_constants(const candidate *c)
+// Print the best gains in the form used by balance.c and motor.c.
+{
+    printf("\n// balance.c\n");
+    printf("#define DEFAULT_P_GAIN      ((int16_t) (%05.2f * 256))\n", gain_from_fixed(GAIN_BALANCE_P, c->gain[GAIN_BALANCE_P]));
+    printf("#define DEFAULT_D_GAIN      ((int16_t) (%05.2f * 256))\n", gain_from_fixed(GAIN_BALANCE_D, c->gain[GAIN_BALANCE_D]));
+    printf("#define DEFAULT_I_GAIN      ((int16_t) (%05.2f * 256 * CONTROL_PERIOD / 20))\n", gain_from_fixed(GAIN_BALANCE_I, c->gain[GAIN_BALANCE_I]));
+    printf("#define DEFAULT_T_COMP      ((int16_t) (%05.2f * 256))\n", gain_from_fixed(GAIN_BALANCE_T, c->gain[GAIN_BALANCE_T]));
+    printf("\n// motor.c\n");
+    printf("#define DEFAULT_P_GAIN          0x%04x\n", (uint16_t) lrint(gain_from_fixed(GAIN_MOTOR_P, c->gain[GAIN_MOTOR_P]) * 256.0));
+    printf("#define DEFAULT_D_GAIN          (0x%04x * 10 / CONTROL_PERIOD)\n", (uint16_t) lrint(gain_from_fixed(GAIN_MOTOR_D, c->gain[GAIN_MOTOR_D]) * 256.0));
+    printf("#define DEFAULT_I_GAIN          (0x%04x * CONTROL_PERIOD / 10)\n", (uint16_t) lrint(gain_from_fixed(GAIN_MOTOR_I, c->gain[GAIN_MOTOR_I]) * 256.0));
+}
+
+
+int main(int argc, char **argv)
+{
+    int opt;
+    int rounds = 2;
+    int top = 10;
+    int round;
+    uint8_t g;
+    uint32_t count;
+    uint32_t i;
+    int16_t defaults[GAIN_COUNT];
+    gain_range refine[GAIN_COUNT];
+    candidate best;
+    candidate *candidates;
+
+    tune_jobs = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (tune_jobs < 1) tune_jobs = 1;
+
+    while ((opt = getopt(argc, argv, "p:d:i:c:P:D:I:t:r:n:j:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'p': range_parse(optarg, &tune_ranges[GAIN_BALANCE_P], argv[0]); break;
+            case 'd': range_parse(optarg, &tune_ranges[GAIN_BALANCE_D], argv[0]); break;
+            case 'i': range_parse(optarg, &tune_ranges[GAIN_BALANCE_I], argv[0]); break;
+            case 'c': range_parse(optarg, &tune_ranges[GAIN_BALANCE_T], argv[0]); break;
+            case 'P': range_parse(optarg, &tune_ranges[GAIN_MOTOR_P], argv[0]); break;
+            case 'D': range_parse(optarg, &tune_ranges[GAIN_MOTOR_D], argv[0]); break;
+            case 'I': range_parse(optarg, &tune_ranges[GAIN_MOTOR_I], argv[0]); break;
+            case 't': tune_duration = atof(optarg); break;
+            case 'r': rounds = atoi(optarg); break;
+            case 'n': top = atoi(optarg); break;
+            case 'j': tune_jobs = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+            default: usage(argv[0]);
+        }
+    }
+
+    // Get the firmware defaults for the gains not being swept.
+    default_gains(defaults);
+
+    // Run the grid sweep.
+    count = grid_build(&candidates, tune_ranges, defaults);
+    fprintf(stderr, "sweeping %u candidates x %u scenarios on %d processes\n", count, (unsigned) SCENARIO_COUNT, tune_jobs);
+    run_candidates(candidates, count);
+    qsort(candidates, count, sizeof(candidate), candidate_compare);
+
+    // Print the ranked candidates.
+    for (i = 0; i < count && i < (uint32_t) top; ++i) print_candidate(&candidates[i]);
+    best = candidates[0];
+    free(candidates);
+
+    // Refine around the best candidate with successively smaller steps.
+    for (round = 1; round <= rounds; ++round)
+    {
+        for (g = 0; g < GAIN_COUNT; ++g)
+        {
+            refine[g] = tune_ranges[g];
+            if (refine[g].step > 0.0 && refine[g].hi > refine[g].lo)
+            {
+                double step = tune_ranges[g].step / (1 << round);
+                double value = gain_from_fixed(g, best.gain[g]);
+
+                // Stay within the range that was asked for.
+                refine[g].lo = fmax(value - step, tune_ranges[g].lo);
+                refine[g].hi = fmin(value + step, tune_ranges[g].hi);
+                refine[g].step = step;
+            }
+            else
+            {
+                refine[g].step = 0.0;
+                defaults[g] = best.gain[g];
+            }
+        }
+
+        count = grid_build(&candidates, refine, defaults);
+        fprintf(stderr, "refinement round %d: %u candidates\n", round, count);
+        run_candidates(candidates, count);
+        qsort(candidates, count, sizeof(candidate), candidate_compare);
+        if (candidates[0].cost < best.cost) best = candidates[0];
+        free(candidates);
+    }
+
+    // Report the best candidate.
+    printf("\nbest:\n");
+    print_candidate(&best);
+    print_constants(&best);
+
+    return 0;
+}
@@ -0,0 +1,212 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Closed loop simulation of the robot control modules.  The control
+    jobs are run in the same order as the control_jobs table in control.c
+    with the plant advanced in small steps between control ticks.
+
+    The control modules keep their state in file scope statics, so
+    sim_run() must only be called once per process.  Callers that need
+    several runs should run each one in its own process.
+*/
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <avr/io.h>
+#include "balance.h"
+#include "blackbox.h"
+#include "bus.h"
+#include "config.h"
+#include "encoder.h"
+#include "heading.h"
+#include "imu.h"
+#include "motor.h"
+#include "odometry.h"
+#include "safety.h"
+#include "sim.h"
+#include "speed.h"
+#include "telemetry.h"
+#include "uio.h"
+#include "usart.h"
+
+// Plant integration steps per millisecond of the control period.
+#define SIM_STEPS_PER_MS        2
+
+// Control ticks between user I/O polls as in control.c.
+#define SIM_UIO_TICKS           (40 / CONTROL_PERIOD)
+
+// Reset flags of the simulated AVR which always starts from power up.
+volatile uint8_t MCUCSR = (1<<PORF);
+
+uint8_t telemetry_frame_send(uint8_t type, const void *payload, uint8_t length)
+// The simulation has no telemetry link so every frame is dropped.
+{
+    return 0;
+}
+
+void sim_config_default(sim_config *config)
+// Default configuration: recover from a five degree disturbance.
+{
+    memset(config, 0, sizeof(sim_config));
+    config->duration = 10.0;
+    config->initial_pitch = 5.0;
+    config->settle_band = 0.5;
+    config->step_time = 5.0;
+    plant_params_default(&config->plant);
+}
+
+
+void sim_run(const sim_config *config, sim_result *result)
+// Run the closed loop simulation.
+{
+    plant_state state;
+    uint32_t tick;
+    uint32_t ticks;
+    uint32_t saturated;
+    uint16_t step;
+    double dt;
+    double pitch;
+    double sign;
+    int32_t odometry_x;
+    int8_t left_pwm;
+    int8_t right_pwm;
+    int16_t left_cmd;
+    int16_t right_cmd;
+
+    memset(result, 0, sizeof(sim_result));
+
+    // Initialize the plant and attach it to the bus.
+    plant_reset(&state, config->initial_pitch * M_PI / 180.0);
+    bus_init(&config->plant, &state);
+    bus_imu_noise_set(config->imu_noise);
+    bus_rc_set(0, 0);
+    usart_init();
+
+    // Initialize the control modules as control_task does.
+    uio_init();
+    imu_init();
+    encoder_init();
+    odometry_init();
+    motor_init();
+    speed_init();
+    balance_init();
+    heading_init();
+    safety_init();
+    blackbox_init();
+
+    // Override the gains.
+    if (config->set_balance_gains)
+    {
+        int16_t p = config->balance_p_gain, d = config->balance_d_gain;
+        int16_t i = config->balance_i_gain, t = config->balance_t_comp;
+        balance_gains_set(&p, &d, &i, &t);
+    }
+    if (config->set_statefb_gains)
+    {
+        int16_t a = config->statefb_angle_gain, r = config->statefb_rate_gain;
+        int16_t p = config->statefb_position_gain, v = config->statefb_velocity_gain;
+        balance_statefb_gains_set(&a, &r, &p, &v);
+    }
+    balance_mode_set(config->balance_mode);
+    if (config->set_motor_gains)
+    {
+        int16_t p = config->motor_p_gain, d = config->motor_d_gain, i = config->motor_i_gain;
+        motor_left_gains_set(&p, &d, &i);
+        motor_right_gains_set(&p, &d, &i);
+    }
+
+    // The motors are enabled from the start.
+    motor_enable_set(1);
+
+    // Sign of the initial disturbance for measuring overshoot.
+    sign = config->initial_pitch < 0.0 ? -1.0 : 1.0;
+
+    // Log header.
+    if (config->log) fprintf(config->log, "time,pitch,pitch_rate,distance,left_cmd,right_cmd,left_pwm,right_pwm\n");
+
+    dt = 0.001 / SIM_STEPS_PER_MS;
+    ticks = (uint32_t) (config->duration * 1000.0 / CONTROL_PERIOD);
+    saturated = 0;
+    result->settle_time = 0.0;
+
+    for (tick = 0; tick < ticks; ++tick)
+    {
+        // Apply the RC step.
+        if (state.time >= config->step_time) bus_rc_set(config->heading_rc, config->speed_rc);
+
+        // Run the control jobs for this tick.
+        safety_update();
+        encoder_update();
+        odometry_update();
+        speed_update();
+        balance_update();
+        heading_update();
+        motor_update();
+        if ((tick % SIM_UIO_TICKS) == SIM_UIO_TICKS / 2) uio_update();
+
+        // Account saturation of the motors.
+        bus_pwm_get(&left_pwm, &right_pwm);
+        if ((abs(left_pwm) >= 127) || (abs(right_pwm) >= 127)) ++saturated;
+
+        // Log the tick.
+        if (config->log)
+        {
+            motor_command_get(&left_cmd, &right_cmd);
+            fprintf(config->log, "%.3f,%.4f,%.4f,%.4f,%d,%d,%d,%d\n", state.time,
+                    state.pitch * 180.0 / M_PI, state.pitch_rate * 180.0 / M_PI,
+                    0.5 * (state.wheel[PLANT_LEFT] + state.wheel[PLANT_RIGHT]) * config->plant.wheel_radius,
+                    left_cmd, right_cmd, left_pwm, right_pwm);
+        }
+
+        // Advance the plant to the next control tick.
+        for (step = 0; step < CONTROL_PERIOD * SIM_STEPS_PER_MS; ++step) plant_step(&config->plant, &state, dt);
+
+        // Stop once fallen.
+        if (state.fallen)
+        {
+            result->fell = 1;
+            result->fall_time = state.time;
+            break;
+        }
+
+        // Track the pitch metrics.
+        pitch = state.pitch * 180.0 / M_PI;
+        if (fabs(pitch) > result->max_pitch) result->max_pitch = fabs(pitch);
+        if (-sign * pitch > result->overshoot) result->overshoot = -sign * pitch;
+        if (fabs(pitch - config->plant.balance_angle * 180.0 / M_PI) > config->settle_band) result->settle_time = state.time;
+    }
+
+    // Final results.
+    result->ticks = tick;
+    result->time = state.time;
+    result->saturation = tick ? (double) saturated / tick : 0.0;
+    result->distance = 0.5 * (state.wheel[PLANT_LEFT] + state.wheel[PLANT_RIGHT]) * config->plant.wheel_radius;
+    odometry_pose_get(&odometry_x, NULL, NULL);
+    result->odometry_x = odometry_x / 65536.0 / 1000.0;
+    if (result->fell) result->settle_time = result->fall_time;
+}
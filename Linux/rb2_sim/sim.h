@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+*/
+
+#ifndef _RB2_SIM_SIM_H_
+#define _RB2_SIM_SIM_H_ 1
+
+#include <stdint.h>
+#include <stdio.h>
+#include "plant.h"
+
+typedef struct
+{
+    double duration;            // Simulated time in s.
+    double initial_pitch;       // Initial pitch disturbance in degrees.
+    double settle_band;         // Pitch band considered settled in degrees.
+    double imu_noise;           // IMU angle noise in degrees.
+    double step_time;           // Time of the RC step in s.
+    int8_t speed_rc;            // RC speed value applied at the step time.
+    int8_t heading_rc;          // RC heading value applied at the step time.
+    uint8_t set_balance_gains;  // Set to override the firmware balance gains.
+    int16_t balance_p_gain;
+    int16_t balance_d_gain;
+    int16_t balance_i_gain;
+    int16_t balance_t_comp;
+    uint8_t balance_mode;       // Balance controller mode.
+    uint8_t set_statefb_gains;  // Set to override the firmware state feedback gains.
+    int16_t statefb_angle_gain;
+    int16_t statefb_rate_gain;
+    int16_t statefb_position_gain;
+    int16_t statefb_velocity_gain;
+    uint8_t set_motor_gains;    // Set to override the firmware motor gains.
+    int16_t motor_p_gain;
+    int16_t motor_d_gain;
+    int16_t motor_i_gain;
+    plant_params plant;         // Plant model parameters.
+    FILE *log;                  // Optional CSV log of each control tick.
+} sim_config;
+
+typedef struct
+{
+    int fell;                   // Set if the robot fell over.
+    double fall_time;           // Time of the fall in s.
+    double settle_time;         // Time after which the pitch stays within the band in s.
+    double overshoot;           // Largest pitch opposite the initial disturbance in degrees.
+    double max_pitch;           // Largest absolute pitch in degrees.
+    double saturation;          // Fraction of motor updates with saturated PWM.
+    double distance;            // Final distance travelled in m.
+    double odometry_x;          // Final odometry x position in m.
+    uint32_t ticks;             // Control ticks simulated.
+    double time;                // Simulated time in s.
+} sim_result;
+
+void sim_config_default(sim_config *config);
+void sim_run(const sim_config *config, sim_result *result);
+
+#endif // _RB2_SIM_SIM_H_
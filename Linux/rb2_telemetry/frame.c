@@ -0,0 +1,118 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Parser of the telemetry frames sent by rb2_avr_robot128 on USART0.
+    See telemetry.h in the firmware for the frame layout.
+*/
+
+#include <stdint.h>
+#include <string.h>
+#include "frame.h"
+#include "telemetry.h"
+
+// Parser states.
+#define FRAME_SYNC1             0
+#define FRAME_SYNC2             1
+#define FRAME_TYPE              2
+#define FRAME_LENGTH            3
+#define FRAME_SEQ_LO            4
+#define FRAME_SEQ_HI            5
+#define FRAME_PAYLOAD           6
+#define FRAME_CRC_LO            7
+#define FRAME_CRC_HI            8
+
+
+uint16_t frame_crc_update(uint16_t crc, uint8_t data)
+// Host version of the avr-libc _crc_ccitt_update().
+{
+    int i;
+
+    crc ^= data;
+    for (i = 0; i < 8; ++i)
+        crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : (crc >> 1);
+
+    return crc;
+}
+
+
+void frame_parser_init(frame_parser *parser)
+{
+    memset(parser, 0, sizeof(*parser));
+}
+
+
+int frame_parser_byte(frame_parser *parser, uint8_t data)
+// Feed a received byte to the parser.  Returns 1 when a frame with a
+// good crc has been received into the parser.
+{
+    switch (parser->state)
+    {
+        case FRAME_SYNC1:
+            if (data == TELEMETRY_SYNC1) parser->state = FRAME_SYNC2;
+            break;
+        case FRAME_SYNC2:
+            if (data == TELEMETRY_SYNC2) parser->state = FRAME_TYPE;
+            else if (data != TELEMETRY_SYNC1) parser->state = FRAME_SYNC1;
+            break;
+        case FRAME_TYPE:
+            parser->type = data;
+            parser->crc = frame_crc_update(0xffff, data);
+            parser->state = FRAME_LENGTH;
+            break;
+        case FRAME_LENGTH:
+            parser->length = data;
+            parser->crc = frame_crc_update(parser->crc, data);
+            parser->state = FRAME_SEQ_LO;
+            break;
+        case FRAME_SEQ_LO:
+            parser->sequence = data;
+            parser->crc = frame_crc_update(parser->crc, data);
+            parser->state = FRAME_SEQ_HI;
+            break;
+        case FRAME_SEQ_HI:
+            parser->sequence |= (uint16_t) data << 8;
+            parser->crc = frame_crc_update(parser->crc, data);
+            parser->count = 0;
+            parser->state = parser->length ? FRAME_PAYLOAD : FRAME_CRC_LO;
+            break;
+        case FRAME_PAYLOAD:
+            parser->payload[parser->count++] = data;
+            parser->crc = frame_crc_update(parser->crc, data);
+            if (parser->count == parser->length) parser->state = FRAME_CRC_LO;
+            break;
+        case FRAME_CRC_LO:
+            parser->crc ^= data;
+            parser->state = FRAME_CRC_HI;
+            break;
+        case FRAME_CRC_HI:
+            parser->crc ^= (uint16_t) data << 8;
+            parser->state = FRAME_SYNC1;
+            if (!parser->crc) return 1;
+            ++parser->crc_errors;
+            break;
+    }
+
+    return 0;
+}
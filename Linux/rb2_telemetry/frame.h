@@ -0,0 +1,53 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Parser of the telemetry frames sent by rb2_avr_robot128 on USART0.
+*/
+
+#ifndef _RB2_TELEMETRY_FRAME_H_
+#define _RB2_TELEMETRY_FRAME_H_ 1
+
+#include <stdint.h>
+
+// Largest frame payload.
+#define FRAME_MAX_PAYLOAD       255
+
+typedef struct
+{
+    uint8_t state;
+    uint8_t type;
+    uint8_t length;
+    uint16_t sequence;
+    uint16_t crc;
+    uint16_t count;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    uint32_t crc_errors;        // Frames discarded for a bad crc.
+} frame_parser;
+
+void frame_parser_init(frame_parser *parser);
+int frame_parser_byte(frame_parser *parser, uint8_t data);
+uint16_t frame_crc_update(uint16_t crc, uint8_t data);
+
+#endif // _RB2_TELEMETRY_FRAME_H_
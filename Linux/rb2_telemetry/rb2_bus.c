@@ -0,0 +1,355 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Decodes the RB2 bus mirror that rb2_avr_robot128 sends when built
+    with BUS_MIRROR.  The words are put back on a common timeline and
+    grouped into transactions, each starting with a select word, so the
+    bus utilization, the idle gaps and the turnaround of each module can
+    be reported per module address.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "config.h"
+#include "frame.h"
+#include "mirror.h"
+#include "serial.h"
+#include "telemetry.h"
+
+// The mirror time runs at the CPU clock divided by 8.
+#define BUS_TICKS_PER_US        (CPUCLK / 8 / 1000000.0)
+
+// Bits on the wire for each 9 bit word.
+#define BUS_WORD_BITS           11
+
+// Upper bounds in microseconds of the idle gap histogram buckets.
+#define BUS_GAP_BUCKETS         6
+static const double bus_gap_limits[BUS_GAP_BUCKETS] = { 10, 50, 100, 1000, 10000, 1e30 };
+static const char *const bus_gap_names[BUS_GAP_BUCKETS] = { "<10us", "<50us", "<100us", "<1ms", "<10ms", ">=10ms" };
+
+typedef struct
+{
+    uint64_t count;
+    double sum;
+    double max;
+} bus_stat;
+
+typedef struct
+{
+    uint64_t transactions;
+    uint64_t words;
+    double time;                // Microseconds from select to last word.
+    bus_stat reply;             // Robot word end to module word end.
+    bus_stat request;           // Module word end to robot word end.
+} bus_module;
+
+static volatile sig_atomic_t bus_stop;
+
+static bus_module bus_modules[256];
+static uint64_t bus_gaps[BUS_GAP_BUCKETS];
+static uint64_t bus_words;
+static uint64_t bus_lost;
+static uint64_t bus_flushed;
+static uint64_t bus_frames_dropped;
+static double bus_elapsed;
+static double bus_word_time;
+
+// Timeline state.  The time is in microseconds and restarts after any
+// lost word since the time between the words either side is unknown.
+static int bus_running;
+static uint16_t bus_last_ticks;
+static double bus_time;
+static double bus_last_time;
+static int bus_last_sent;
+static int bus_address = -1;
+static double bus_select_time;
+
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  -d device      serial device of the telemetry link\n"
+        "  -b baud        serial baud rate (default 250000)\n"
+        "  -r file        raw capture to replay instead of a device\n"
+        "  -B baud        RB2 bus baud rate (default 500000)\n"
+        "  -v             print every word\n",
+        name);
+    exit(1);
+}
+
+
+static void bus_signal(int sig)
+{
+    (void) sig;
+    bus_stop = 1;
+}
+
+
+static void bus_stat_add(bus_stat *stat, double value)
+{
+    ++stat->count;
+    stat->sum += value;
+    if (value > stat->max) stat->max = value;
+}
+
+
+static void bus_transaction_end(void)
+// Account the open transaction up to the end of its last word.
+{
+    if (bus_address < 0) return;
+
+    bus_modules[bus_address].time += bus_last_time - bus_select_time;
+    bus_address = -1;
+}
+
+
+static void bus_break(void)
+// Break the timeline where words were lost.
+{
+    bus_transaction_end();
+    bus_running = 0;
+}
+
+
+static void bus_word(uint16_t ticks, uint16_t data, int sent, int verbose)
+// Place a mirrored word on the timeline.  The time is when the word was
+// received so the word started one word time earlier.
+{
+    double gap;
+    int i;
+
+    // Unwrap the 16 bit time assuming no two words are a whole timer
+    // period apart, which holds while the control loop runs the bus.
+    if (!bus_running)
+    {
+        bus_time = 0;
+    }
+    else
+    {
+        bus_time += (uint16_t) (ticks - bus_last_ticks) / BUS_TICKS_PER_US;
+        bus_elapsed += bus_time - bus_last_time;
+
+        // Idle time between the words.
+        gap = bus_time - bus_last_time - bus_word_time;
+        if (gap < 0) gap = 0;
+        for (i = 0; gap >= bus_gap_limits[i]; ++i);
+        ++bus_gaps[i];
+
+        // The gap is a turnaround within a transaction when the sender
+        // changes.
+        if ((bus_address >= 0) && !(data & 0x0100) && (sent != bus_last_sent))
+        {
+            if (sent) bus_stat_add(&bus_modules[bus_address].request, gap);
+            else bus_stat_add(&bus_modules[bus_address].reply, gap);
+        }
+    }
+
+    // A word with the ninth bit set selects a module and starts a new
+    // transaction.
+    if (data & 0x0100)
+    {
+        bus_transaction_end();
+        bus_address = data & 0xff;
+        bus_select_time = bus_time - bus_word_time;
+        ++bus_modules[bus_address].transactions;
+    }
+    if (bus_address >= 0) ++bus_modules[bus_address].words;
+
+    if (verbose)
+        printf("%14.1f %s %03x%s\n", bus_time, sent ? "tx" : "rx", data, bus_running ? "" : "  (restart)");
+
+    bus_running = 1;
+    bus_last_ticks = ticks;
+    bus_last_time = bus_time;
+    bus_last_sent = sent;
+    ++bus_words;
+}
+
+
+static void bus_frame(const frame_parser *parser, int verbose)
+// Place the words of a bus frame on the timeline.
+{
+    int i;
+    const uint8_t *entry;
+
+    if (parser->length < 1) return;
+
+    // Words lost on the robot break the timeline.
+    if (parser->payload[0])
+    {
+        bus_lost += parser->payload[0];
+        bus_break();
+    }
+
+    for (i = 0; 1 + (i + 1) * 4 <= parser->length; ++i)
+    {
+        entry = parser->payload + 1 + i * 4;
+
+        // Words flushed unread carry the time they were flushed rather
+        // than received so they are counted but kept off the timeline.
+        if (entry[3] & MIRROR_FLAG_FLUSHED)
+        {
+            ++bus_flushed;
+            if (verbose)
+                printf("%14s fl %03x\n", "",
+                       (unsigned) (entry[2] | ((entry[3] & MIRROR_FLAG_BIT8) ? 0x0100 : 0)));
+            continue;
+        }
+
+        bus_word((uint16_t) (entry[0] | (entry[1] << 8)),
+                 (uint16_t) (entry[2] | ((entry[3] & MIRROR_FLAG_BIT8) ? 0x0100 : 0)),
+                 (entry[3] & MIRROR_FLAG_SENT) ? 1 : 0, verbose);
+    }
+}
+
+
+static void bus_stat_print(const bus_stat *stat)
+{
+    if (stat->count)
+        printf(" %8.1f %8.1f", stat->sum / stat->count, stat->max);
+    else
+        printf(" %8s %8s", "-", "-");
+}
+
+
+static void bus_report(void)
+{
+    int i;
+    double busy = bus_words * bus_word_time;
+
+    printf("words: %llu  lost: %llu  flushed: %llu  dropped frames: %llu\n",
+           (unsigned long long) bus_words, (unsigned long long) bus_lost,
+           (unsigned long long) bus_flushed, (unsigned long long) bus_frames_dropped);
+    printf("elapsed: %.3f s  busy: %.3f s  utilization: %.1f%%\n",
+           bus_elapsed / 1e6, busy / 1e6, bus_elapsed > 0 ? 100.0 * busy / bus_elapsed : 0.0);
+
+    printf("\nidle gaps:");
+    for (i = 0; i < BUS_GAP_BUCKETS; ++i)
+        printf("  %s %llu", bus_gap_names[i], (unsigned long long) bus_gaps[i]);
+    printf("\n\n");
+
+    printf("%-7s %8s %8s %10s %8s %17s %17s\n", "module", "trans", "words", "us/trans",
+           "share", "reply mean/max", "request mean/max");
+    for (i = 0; i < 256; ++i)
+    {
+        const bus_module *m = &bus_modules[i];
+
+        if (!m->transactions) continue;
+        printf("0x%02x    %8llu %8llu %10.1f %7.1f%%", i, (unsigned long long) m->transactions,
+               (unsigned long long) m->words, m->time / m->transactions,
+               bus_elapsed > 0 ? 100.0 * m->time / bus_elapsed : 0.0);
+        bus_stat_print(&m->reply);
+        bus_stat_print(&m->request);
+        printf("\n");
+    }
+}
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int fd;
+    int opt;
+    int baud = 250000;
+    int bus_baud = 500000;
+    int verbose = 0;
+    int started = 0;
+    ssize_t n;
+    uint8_t data[4096];
+    uint16_t sequence = 0;
+    const char *device = NULL;
+    const char *replay = NULL;
+    frame_parser parser;
+
+    while ((opt = getopt(argc, argv, "d:b:r:B:v")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': device = optarg; break;
+            case 'b': baud = atoi(optarg); break;
+            case 'r': replay = optarg; break;
+            case 'B': bus_baud = atoi(optarg); break;
+            case 'v': verbose = 1; break;
+            default: usage(argv[0]);
+        }
+    }
+    if ((optind != argc) || (!device == !replay) || (bus_baud <= 0)) usage(argv[0]);
+
+    bus_word_time = BUS_WORD_BITS * 1e6 / bus_baud;
+
+    // Open the source.
+    fd = device ? serial_open(device, baud, O_RDONLY) : open(replay, O_RDONLY);
+    if (fd < 0) { perror(device ? device : replay); return 1; }
+
+    // Report on an interrupt.
+    signal(SIGINT, bus_signal);
+    signal(SIGTERM, bus_signal);
+
+    frame_parser_init(&parser);
+
+    while (!bus_stop)
+    {
+        n = read(fd, data, sizeof(data));
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            perror("read");
+            break;
+        }
+        if (n == 0) break;
+
+        for (i = 0; i < n; ++i)
+        {
+            if (!frame_parser_byte(&parser, data[i])) continue;
+            if (parser.type != TELEMETRY_FRAME_BUS) continue;
+
+            // Frames dropped on the robot break the timeline.
+            if (started && (parser.sequence != (uint16_t) (sequence + 1)))
+            {
+                bus_frames_dropped += (uint16_t) (parser.sequence - sequence - 1);
+                bus_break();
+            }
+            started = 1;
+            sequence = parser.sequence;
+
+            bus_frame(&parser, verbose);
+        }
+    }
+
+    bus_transaction_end();
+    close(fd);
+
+    bus_report();
+    fprintf(stderr, "crc errors: %u\n", parser.crc_errors);
+
+    return 0;
+}
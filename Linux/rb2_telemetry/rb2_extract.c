@@ -0,0 +1,165 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Extracts channels from a telemetry log as CSV.  The start of the range
+    is found with a binary search of the block index and only the columns
+    asked for are read, so pulling one channel out of a long run touches a
+    small fraction of the file.
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "tlog.h"
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options] log\n"
+        "  -s seconds     start of the range (default 0)\n"
+        "  -e seconds     end of the range (default end of log)\n"
+        "  -c a,b,...     channels to extract (default all)\n"
+        "  -i             print a summary of the log\n",
+        name);
+    exit(1);
+}
+
+
+static void info(const tlog_reader *reader)
+// Print a summary of the log from the first and last block headers.
+{
+    const tlog_block_header *first;
+    const tlog_block_header *last;
+    double period = reader->header->period_us * 1e-6;
+
+    printf("block size:  %u bytes of %u records\n", reader->header->block_size, reader->header->block_records);
+    printf("period:      %u us\n", reader->header->period_us);
+    printf("blocks:      %llu\n", (unsigned long long) reader->blocks);
+    if (!reader->blocks) return;
+
+    first = tlog_block(reader, 0);
+    last = tlog_block(reader, reader->blocks - 1);
+    printf("records:     %llu\n", (unsigned long long) ((reader->blocks - 1) * reader->header->block_records + last->count));
+    printf("ticks:       %llu to %llu\n", (unsigned long long) first->first_tick, (unsigned long long) last->last_tick);
+    printf("time:        %.3f to %.3f s\n", first->first_tick * period, last->last_tick * period);
+}
+
+
+int main(int argc, char **argv)
+{
+    int c;
+    int opt;
+    int show_info = 0;
+    int channels[TLOG_CHANNELS];
+    int channel_count = 0;
+    char *name;
+    char *list = NULL;
+    double start = 0.0;
+    double end = -1.0;
+    double period;
+    uint64_t tick;
+    uint64_t end_tick;
+    uint64_t block;
+    uint32_t index;
+    const tlog_block_header *bh;
+    const uint32_t *ticks;
+    const int16_t *columns[TLOG_CHANNELS];
+    tlog_reader reader;
+
+    while ((opt = getopt(argc, argv, "s:e:c:i")) != -1)
+    {
+        switch (opt)
+        {
+            case 's': start = atof(optarg); break;
+            case 'e': end = atof(optarg); break;
+            case 'c': list = optarg; break;
+            case 'i': show_info = 1; break;
+            default: usage(argv[0]);
+        }
+    }
+    if (optind != argc - 1) usage(argv[0]);
+
+    // Look up the channels.
+    if (list)
+    {
+        for (name = strtok(list, ","); name; name = strtok(NULL, ","))
+        {
+            c = tlog_channel_find(name);
+            if ((c < 0) || (channel_count == TLOG_CHANNELS)) { fprintf(stderr, "unknown channel %s\n", name); return 1; }
+            channels[channel_count++] = c;
+        }
+    }
+    else
+    {
+        for (c = 0; c < TLOG_CHANNELS; ++c) channels[channel_count++] = c;
+    }
+
+    if (tlog_reader_open(&reader, argv[optind]) < 0) { perror(argv[optind]); return 1; }
+
+    if (show_info)
+    {
+        info(&reader);
+        tlog_reader_close(&reader);
+        return 0;
+    }
+
+    // Convert the range to ticks.
+    period = reader.header->period_us * 1e-6;
+    tick = start > 0.0 ? (uint64_t) (start / period + 0.5) : 0;
+    end_tick = end >= 0.0 ? (uint64_t) (end / period + 0.5) : UINT64_MAX;
+
+    // Header.
+    printf("time");
+    for (c = 0; c < channel_count; ++c) printf(",%s", tlog_channel_names[channels[c]]);
+    printf("\n");
+
+    // Walk the records from the start of the range.
+    if (tlog_seek(&reader, tick, &block, &index) == 0)
+    {
+        for (; block < reader.blocks; ++block, index = 0)
+        {
+            bh = tlog_block(&reader, block);
+            ticks = tlog_block_ticks(&reader, block);
+            for (c = 0; c < channel_count; ++c) columns[c] = tlog_block_channel(&reader, block, channels[c]);
+
+            for (; index < bh->count; ++index)
+            {
+                tick = bh->first_tick + ticks[index];
+                if (tick > end_tick) goto done;
+
+                printf("%.3f", tick * period);
+                for (c = 0; c < channel_count; ++c) printf(",%d", columns[c][index]);
+                printf("\n");
+            }
+        }
+    }
+
+done:
+    tlog_reader_close(&reader);
+
+    return 0;
+}
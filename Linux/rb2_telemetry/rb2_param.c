@@ -0,0 +1,236 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Reads and writes the robot gains over the telemetry link.  All the
+    parameters named on the command line go in a single request so the
+    writes are applied together between two control ticks.
+*/
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "frame.h"
+#include "rpc.h"
+#include "serial.h"
+#include "telemetry.h"
+
+// Parameter names in parameter number order.
+static const char *const param_names[PARAM_COUNT] =
+{
+    "balance_p",
+    "balance_d",
+    "balance_i",
+    "balance_t_comp",
+    "speed_p",
+    "speed_d",
+    "speed_i",
+    "motor_left_p",
+    "motor_left_d",
+    "motor_left_i",
+    "motor_right_p",
+    "motor_right_d",
+    "motor_right_i",
+    "statefb_angle",
+    "statefb_rate",
+    "statefb_position",
+    "statefb_velocity",
+};
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options] [param[=value]]...\n"
+        "  -d device      serial device of the telemetry link\n"
+        "  -b baud        serial baud rate (default 250000)\n"
+        "  -t ms          reply timeout in milliseconds (default 1000)\n"
+        "\n"
+        "Values with a decimal point are 8:8 fixed point.  With no\n"
+        "parameters every parameter is read.\n",
+        name);
+    exit(1);
+}
+
+
+static int param_find(const char *name, size_t length)
+{
+    int i;
+
+    for (i = 0; i < PARAM_COUNT; ++i)
+        if ((strlen(param_names[i]) == length) && !strncmp(name, param_names[i], length)) return i;
+
+    return -1;
+}
+
+
+static int write_all(int fd, const uint8_t *data, size_t size)
+{
+    ssize_t n;
+
+    while (size)
+    {
+        n = write(fd, data, size);
+        if (n < 0) return -1;
+        data += n;
+        size -= (size_t) n;
+    }
+
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int fd;
+    int opt;
+    int param;
+    int baud = 250000;
+    int timeout = 1000;
+    ssize_t n;
+    char *value;
+    uint8_t payload[RPC_MAX_PAYLOAD];
+    uint8_t frame[RPC_MAX_PAYLOAD + TELEMETRY_FRAME_OVERHEAD];
+    uint8_t data[256];
+    uint8_t length = 0;
+    uint16_t sequence;
+    uint16_t crc;
+    int16_t v;
+    double fixed;
+    const char *device = NULL;
+    struct pollfd pfd;
+    frame_parser parser;
+
+    while ((opt = getopt(argc, argv, "d:b:t:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': device = optarg; break;
+            case 'b': baud = atoi(optarg); break;
+            case 't': timeout = atoi(optarg); break;
+            default: usage(argv[0]);
+        }
+    }
+    if (!device) usage(argv[0]);
+
+    // Build the request.
+    if (optind == argc)
+    {
+        for (i = 0; i < PARAM_COUNT; ++i)
+        {
+            payload[length++] = RPC_OP_READ;
+            payload[length++] = (uint8_t) i;
+        }
+    }
+    for (i = optind; i < argc; ++i)
+    {
+        value = strchr(argv[i], '=');
+        param = param_find(argv[i], value ? (size_t) (value - argv[i]) : strlen(argv[i]));
+        if (param < 0) { fprintf(stderr, "unknown parameter %s\n", argv[i]); return 1; }
+        if (length + (value ? 4 : 2) > RPC_MAX_PAYLOAD) { fprintf(stderr, "too many parameters for one request\n"); return 1; }
+
+        if (value)
+        {
+            ++value;
+            if (strchr(value, '.'))
+            {
+                fixed = atof(value) * 256.0;
+                v = (int16_t) (fixed < 0.0 ? fixed - 0.5 : fixed + 0.5);
+            }
+            else
+            {
+                v = (int16_t) strtol(value, NULL, 0);
+            }
+            payload[length++] = RPC_OP_WRITE;
+            payload[length++] = (uint8_t) param;
+            payload[length++] = (uint16_t) v & 0xff;
+            payload[length++] = (uint16_t) v >> 8;
+        }
+        else
+        {
+            payload[length++] = RPC_OP_READ;
+            payload[length++] = (uint8_t) param;
+        }
+    }
+
+    // Frame the request.
+    sequence = (uint16_t) getpid();
+    frame[0] = TELEMETRY_SYNC1;
+    frame[1] = TELEMETRY_SYNC2;
+    frame[2] = TELEMETRY_FRAME_PARAM;
+    frame[3] = length;
+    frame[4] = sequence & 0xff;
+    frame[5] = sequence >> 8;
+    memcpy(frame + 6, payload, length);
+    crc = 0xffff;
+    for (i = 2; i < 6 + length; ++i) crc = frame_crc_update(crc, frame[i]);
+    frame[6 + length] = crc & 0xff;
+    frame[7 + length] = crc >> 8;
+
+    fd = serial_open(device, baud, O_RDWR);
+    if (fd < 0) { perror(device); return 1; }
+    if (write_all(fd, frame, 8 + length) < 0) { perror("write"); return 1; }
+
+    // Wait for the reply among the telemetry frames.
+    frame_parser_init(&parser);
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (poll(&pfd, 1, timeout) > 0)
+    {
+        n = read(fd, data, sizeof(data));
+        if (n <= 0) break;
+
+        for (i = 0; i < n; ++i)
+        {
+            if (!frame_parser_byte(&parser, data[i])) continue;
+            if ((parser.type != TELEMETRY_FRAME_PARAM) || (parser.length < 3)) continue;
+            if ((parser.payload[0] | (parser.payload[1] << 8)) != sequence) continue;
+
+            if (parser.payload[2] != RPC_OK)
+            {
+                fprintf(stderr, "request failed: %s\n", parser.payload[2] == RPC_BAD_PARAM ? "bad parameter" : "bad request");
+                return 1;
+            }
+
+            for (i = 3; i + 3 <= parser.length; i += 3)
+            {
+                param = parser.payload[i];
+                v = (int16_t) (parser.payload[i + 1] | (parser.payload[i + 2] << 8));
+                printf("%-18s %6d  0x%04x  %8.3f\n", param < PARAM_COUNT ? param_names[param] : "?",
+                       v, (uint16_t) v, v / 256.0);
+            }
+            close(fd);
+            return 0;
+        }
+    }
+
+    fprintf(stderr, "no reply\n");
+    close(fd);
+
+    return 1;
+}
@@ -0,0 +1,208 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Records the telemetry frames from a serial device or a replay of a raw
+    capture into an append-only columnar log.  Gaps in the frame sequence
+    left by frames dropped on the robot are kept as gaps in the log ticks.
+    Blackbox records sent after a freeze can be saved to a CSV file.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "config.h"
+#include "frame.h"
+#include "serial.h"
+#include "telemetry.h"
+#include "tlog.h"
+
+static volatile sig_atomic_t record_stop;
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+        "usage: %s [options] log\n"
+        "  -d device      serial device to record from\n"
+        "  -b baud        serial baud rate (default 250000)\n"
+        "  -r file        raw capture to replay instead of a device\n"
+        "  -p ms          control period in milliseconds (default %d)\n"
+        "  -x file        write blackbox records to a CSV file\n",
+        name, CONTROL_PERIOD);
+    exit(1);
+}
+
+
+static void record_signal(int sig)
+{
+    (void) sig;
+    record_stop = 1;
+}
+
+
+static int16_t frame_word(const uint8_t *bytes)
+{
+    return (int16_t) (bytes[0] | (bytes[1] << 8));
+}
+
+
+static void blackbox_save(FILE *file, const frame_parser *parser)
+// Write the blackbox records of a frame.  Each frame holds the freeze
+// reason, the index of its first record and the 8 byte records.
+{
+    int i;
+    const uint8_t *record;
+
+    if (parser->length < 2) return;
+
+    for (i = 0; (i + 1) * 8 <= parser->length - 2; ++i)
+    {
+        record = parser->payload + 2 + i * 8;
+        fprintf(file, "%u,%u,%d,%d,%d,%d,%d\n", parser->payload[0], parser->payload[1] + i,
+                frame_word(record + 0), frame_word(record + 2), frame_word(record + 4),
+                (int8_t) record[6], (int8_t) record[7]);
+    }
+    fflush(file);
+}
+
+
+int main(int argc, char **argv)
+{
+    int i;
+    int fd;
+    int opt;
+    int baud = 250000;
+    int period = CONTROL_PERIOD;
+    int started = 0;
+    ssize_t n;
+    uint8_t data[4096];
+    int16_t values[TLOG_CHANNELS];
+    uint16_t sequence = 0;
+    uint64_t tick = 0;
+    uint64_t frames = 0;
+    uint64_t dropped = 0;
+    int64_t host_time_ns;
+    struct timespec now;
+    const char *device = NULL;
+    const char *replay = NULL;
+    FILE *blackbox = NULL;
+    frame_parser parser;
+    tlog_writer writer;
+
+    while ((opt = getopt(argc, argv, "d:b:r:p:x:")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': device = optarg; break;
+            case 'b': baud = atoi(optarg); break;
+            case 'r': replay = optarg; break;
+            case 'p': period = atoi(optarg); break;
+            case 'x':
+                blackbox = fopen(optarg, "w");
+                if (!blackbox) { perror(optarg); return 1; }
+                fprintf(blackbox, "reason,record,pitch_angle,pitch_rate,tilt,left_pwm,right_pwm\n");
+                break;
+            default: usage(argv[0]);
+        }
+    }
+    if ((optind != argc - 1) || (!device == !replay) || (period <= 0)) usage(argv[0]);
+
+    // Open the source.
+    fd = device ? serial_open(device, baud, O_RDONLY) : open(replay, O_RDONLY);
+    if (fd < 0) { perror(device ? device : replay); return 1; }
+
+    // Open the log.
+    if (tlog_writer_open(&writer, argv[optind], (uint32_t) period * 1000) < 0) { perror(argv[optind]); return 1; }
+
+    // Stop cleanly on an interrupt so the last records are written.
+    signal(SIGINT, record_signal);
+    signal(SIGTERM, record_signal);
+
+    frame_parser_init(&parser);
+
+    while (!record_stop)
+    {
+        n = read(fd, data, sizeof(data));
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            perror("read");
+            break;
+        }
+        if (n == 0) break;
+
+        clock_gettime(CLOCK_REALTIME, &now);
+        host_time_ns = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+
+        for (i = 0; i < n; ++i)
+        {
+            if (!frame_parser_byte(&parser, data[i])) continue;
+            if ((parser.type == TELEMETRY_FRAME_BLACKBOX) && blackbox) blackbox_save(blackbox, &parser);
+            if ((parser.type != TELEMETRY_FRAME_CONTROL) || (parser.length != sizeof(telemetry_control))) continue;
+            if (started && (parser.sequence == sequence)) continue;
+
+            // Unwrap the 16 bit sequence into the log tick.  A new capture
+            // appended to an existing log continues after its last tick.
+            if (!started)
+            {
+                tick = writer.records ? writer.last_tick + 1 : 0;
+                started = 1;
+            }
+            else
+            {
+                tick += (uint16_t) (parser.sequence - sequence);
+                dropped += (uint16_t) (parser.sequence - sequence) - 1;
+            }
+            sequence = parser.sequence;
+
+            // The payload is the telemetry_control structure.
+            values[TLOG_PITCH_ANGLE] = frame_word(parser.payload + 0);
+            values[TLOG_PITCH_RATE] = frame_word(parser.payload + 2);
+            values[TLOG_TILT] = frame_word(parser.payload + 4);
+            values[TLOG_LEFT_DELTA] = frame_word(parser.payload + 6);
+            values[TLOG_RIGHT_DELTA] = frame_word(parser.payload + 8);
+            values[TLOG_LEFT_PWM] = (int8_t) parser.payload[10];
+            values[TLOG_RIGHT_PWM] = (int8_t) parser.payload[11];
+
+            if (tlog_writer_append(&writer, tick, values, host_time_ns) < 0) { perror("append"); record_stop = 1; break; }
+            ++frames;
+        }
+    }
+
+    tlog_writer_close(&writer);
+    if (blackbox) fclose(blackbox);
+    close(fd);
+
+    fprintf(stderr, "frames: %llu  dropped: %llu  crc errors: %u  log records: %llu\n",
+            (unsigned long long) frames, (unsigned long long) dropped,
+            parser.crc_errors, (unsigned long long) writer.records);
+
+    return 0;
+}
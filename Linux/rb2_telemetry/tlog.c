@@ -0,0 +1,369 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Append-only columnar log of the telemetry control frames.
+*/
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "tlog.h"
+
+// Records between writes of the block being filled.
+#define TLOG_FLUSH_RECORDS      100
+
+const char *const tlog_channel_names[TLOG_CHANNELS] =
+{
+    "pitch_angle",
+    "pitch_rate",
+    "tilt",
+    "left_delta",
+    "right_delta",
+    "left_pwm",
+    "right_pwm",
+};
+
+
+static uint32_t tlog_block_size(void)
+// Size of a block rounded up to a whole number of pages.
+{
+    size_t size = TLOG_CHANNEL_OFFSET(TLOG_CHANNELS);
+
+    return (uint32_t) ((size + 4095) & ~(size_t) 4095);
+}
+
+
+static int tlog_write_all(int fd, const void *data, size_t size, off_t offset)
+// Write the whole buffer at the offset.
+{
+    const uint8_t *bytes = (const uint8_t *) data;
+    ssize_t n;
+
+    while (size)
+    {
+        n = pwrite(fd, bytes, size, offset);
+        if (n < 0)
+        {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        bytes += n;
+        size -= (size_t) n;
+        offset += n;
+    }
+
+    return 0;
+}
+
+
+static off_t tlog_block_offset(const tlog_header *header, uint64_t block)
+{
+    return (off_t) TLOG_HEADER_SIZE + (off_t) block * header->block_size;
+}
+
+
+static int tlog_header_valid(const tlog_header *header)
+{
+    return (header->magic == TLOG_MAGIC) &&
+           (header->version == TLOG_VERSION) &&
+           (header->channels == TLOG_CHANNELS) &&
+           (header->block_records == TLOG_BLOCK_RECORDS) &&
+           (header->block_size == tlog_block_size());
+}
+
+
+int tlog_writer_open(tlog_writer *writer, const char *path, uint32_t period_us)
+// Open a log for appending.  An existing log is continued from its last
+// record, otherwise a new log is created.  Returns 0 on success.
+{
+    struct stat st;
+    struct timespec now;
+    tlog_block_header *bh;
+    uint64_t blocks;
+
+    memset(writer, 0, sizeof(*writer));
+
+    writer->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (writer->fd < 0) return -1;
+    if (fstat(writer->fd, &st) < 0) goto fail;
+
+    writer->buffer = calloc(1, tlog_block_size());
+    if (!writer->buffer) goto fail;
+    bh = (tlog_block_header *) writer->buffer;
+
+    if (st.st_size == 0)
+    {
+        // Create the header of a new log.
+        clock_gettime(CLOCK_REALTIME, &now);
+        writer->header.magic = TLOG_MAGIC;
+        writer->header.version = TLOG_VERSION;
+        writer->header.channels = TLOG_CHANNELS;
+        writer->header.block_records = TLOG_BLOCK_RECORDS;
+        writer->header.block_size = tlog_block_size();
+        writer->header.period_us = period_us;
+        writer->header.start_time_ns = (int64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+        if (tlog_write_all(writer->fd, &writer->header, sizeof(writer->header), 0) < 0) goto fail;
+        if (ftruncate(writer->fd, TLOG_HEADER_SIZE) < 0) goto fail;
+        return 0;
+    }
+
+    // Continue an existing log.
+    if (pread(writer->fd, &writer->header, sizeof(writer->header), 0) != (ssize_t) sizeof(writer->header)) goto fail;
+    if (!tlog_header_valid(&writer->header)) { errno = EINVAL; goto fail; }
+
+    // Load the last block that holds records.
+    blocks = (st.st_size - TLOG_HEADER_SIZE) / writer->header.block_size;
+    while (blocks)
+    {
+        if (pread(writer->fd, writer->buffer, writer->header.block_size,
+                  tlog_block_offset(&writer->header, blocks - 1)) != (ssize_t) writer->header.block_size) goto fail;
+        if ((bh->magic == TLOG_BLOCK_MAGIC) && bh->count) break;
+        --blocks;
+    }
+
+    if (blocks)
+    {
+        writer->block = blocks - 1;
+        writer->records = writer->block * TLOG_BLOCK_RECORDS + bh->count;
+        writer->last_tick = bh->last_tick;
+
+        // Start the next block if the last one is full.
+        if (bh->count == TLOG_BLOCK_RECORDS)
+        {
+            ++writer->block;
+            memset(writer->buffer, 0, writer->header.block_size);
+        }
+    }
+    else
+    {
+        memset(writer->buffer, 0, writer->header.block_size);
+    }
+
+    return 0;
+
+fail:
+    free(writer->buffer);
+    close(writer->fd);
+    writer->buffer = NULL;
+    writer->fd = -1;
+    return -1;
+}
+
+
+int tlog_writer_flush(tlog_writer *writer)
+// Write the block being filled.  The columns are written before the block
+// header so the record count never covers unwritten records.
+{
+    tlog_block_header *bh = (tlog_block_header *) writer->buffer;
+    off_t offset = tlog_block_offset(&writer->header, writer->block);
+
+    if (!writer->unflushed) return 0;
+
+    if (tlog_write_all(writer->fd, writer->buffer + sizeof(*bh),
+                       writer->header.block_size - sizeof(*bh), offset + sizeof(*bh)) < 0) return -1;
+    if (tlog_write_all(writer->fd, bh, sizeof(*bh), offset) < 0) return -1;
+
+    writer->unflushed = 0;
+
+    return 0;
+}
+
+
+int tlog_writer_append(tlog_writer *writer, uint64_t tick, const int16_t *values, int64_t host_time_ns)
+// Append a record.  Ticks must increase from record to record.
+{
+    int c;
+    uint32_t i;
+    tlog_block_header *bh = (tlog_block_header *) writer->buffer;
+
+    if (writer->records && (tick <= writer->last_tick)) { errno = EINVAL; return -1; }
+
+    // Move to a new block when this one is full or the tick offset overflows.
+    if (bh->count && ((bh->count == TLOG_BLOCK_RECORDS) || (tick - bh->first_tick > 0xffffffff)))
+    {
+        if (tlog_writer_flush(writer) < 0) return -1;
+        memset(writer->buffer, 0, writer->header.block_size);
+        ++writer->block;
+    }
+
+    // Start the block.
+    if (!bh->count)
+    {
+        bh->magic = TLOG_BLOCK_MAGIC;
+        bh->first_tick = tick;
+        bh->host_time_ns = host_time_ns;
+    }
+
+    // Store the record in the columns.
+    i = bh->count;
+    ((uint32_t *) (writer->buffer + TLOG_TICKS_OFFSET))[i] = (uint32_t) (tick - bh->first_tick);
+    for (c = 0; c < TLOG_CHANNELS; ++c)
+        ((int16_t *) (writer->buffer + TLOG_CHANNEL_OFFSET(c)))[i] = values[c];
+    bh->last_tick = tick;
+    bh->count = i + 1;
+
+    writer->records += 1;
+    writer->last_tick = tick;
+
+    // Write the block periodically so readers see the records.
+    if (++writer->unflushed >= TLOG_FLUSH_RECORDS) return tlog_writer_flush(writer);
+
+    return 0;
+}
+
+
+void tlog_writer_close(tlog_writer *writer)
+{
+    if (writer->fd < 0) return;
+    tlog_writer_flush(writer);
+    free(writer->buffer);
+    close(writer->fd);
+    writer->buffer = NULL;
+    writer->fd = -1;
+}
+
+
+int tlog_reader_open(tlog_reader *reader, const char *path)
+// Map a log for reading.  Returns 0 on success.
+{
+    struct stat st;
+    const tlog_block_header *bh;
+
+    memset(reader, 0, sizeof(*reader));
+
+    reader->fd = open(path, O_RDONLY);
+    if (reader->fd < 0) return -1;
+    if (fstat(reader->fd, &st) < 0) goto fail;
+    if (st.st_size < TLOG_HEADER_SIZE) { errno = EINVAL; goto fail; }
+
+    reader->size = (size_t) st.st_size;
+    reader->map = mmap(NULL, reader->size, PROT_READ, MAP_SHARED, reader->fd, 0);
+    if (reader->map == MAP_FAILED) { reader->map = NULL; goto fail; }
+
+    reader->header = (const tlog_header *) reader->map;
+    if (!tlog_header_valid(reader->header)) { errno = EINVAL; goto fail; }
+
+    // Only whole blocks holding records count.  A partly written last
+    // block has a zero count until its first flush.
+    reader->blocks = (reader->size - TLOG_HEADER_SIZE) / reader->header->block_size;
+    while (reader->blocks)
+    {
+        bh = tlog_block(reader, reader->blocks - 1);
+        if ((bh->magic == TLOG_BLOCK_MAGIC) && bh->count) break;
+        --reader->blocks;
+    }
+
+    return 0;
+
+fail:
+    tlog_reader_close(reader);
+    return -1;
+}
+
+
+void tlog_reader_close(tlog_reader *reader)
+{
+    if (reader->map) munmap((void *) reader->map, reader->size);
+    if (reader->fd >= 0) close(reader->fd);
+    reader->map = NULL;
+    reader->fd = -1;
+}
+
+
+const tlog_block_header *tlog_block(const tlog_reader *reader, uint64_t block)
+{
+    return (const tlog_block_header *) (reader->map + tlog_block_offset(reader->header, block));
+}
+
+
+const uint32_t *tlog_block_ticks(const tlog_reader *reader, uint64_t block)
+{
+    return (const uint32_t *) ((const uint8_t *) tlog_block(reader, block) + TLOG_TICKS_OFFSET);
+}
+
+
+const int16_t *tlog_block_channel(const tlog_reader *reader, uint64_t block, int channel)
+{
+    return (const int16_t *) ((const uint8_t *) tlog_block(reader, block) + TLOG_CHANNEL_OFFSET(channel));
+}
+
+
+int tlog_seek(const tlog_reader *reader, uint64_t tick, uint64_t *block, uint32_t *index)
+// Find the first record at or after the tick.  Only the block headers
+// along the search path and the tick column of one block are touched.
+// Returns 0 if found or -1 if the tick is past the end of the log.
+{
+    uint64_t lo = 0;
+    uint64_t hi = reader->blocks;
+    uint64_t mid;
+    uint32_t first;
+    uint32_t last;
+    uint32_t i;
+    const tlog_block_header *bh;
+    const uint32_t *ticks;
+
+    // Find the first block whose last tick is at or after the tick.
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (tlog_block(reader, mid)->last_tick < tick) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == reader->blocks) return -1;
+
+    // Find the record within the block.
+    bh = tlog_block(reader, lo);
+    ticks = tlog_block_ticks(reader, lo);
+    first = 0;
+    last = bh->count;
+    while (first < last)
+    {
+        i = first + (last - first) / 2;
+        if (bh->first_tick + ticks[i] < tick) first = i + 1;
+        else last = i;
+    }
+
+    *block = lo;
+    *index = first;
+
+    return 0;
+}
+
+
+int tlog_channel_find(const char *name)
+// Get the channel with the name or -1 if there is none.
+{
+    int c;
+
+    for (c = 0; c < TLOG_CHANNELS; ++c)
+        if (!strcmp(name, tlog_channel_names[c])) return c;
+
+    return -1;
+}
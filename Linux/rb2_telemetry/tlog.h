@@ -0,0 +1,121 @@
+/*
+    Copyright (c) 2013 Michael P. Thompson <mpthompson@gmail.com>
+
+    Permission is hereby granted, free of charge, to any person
+    obtaining a copy of this software and associated documentation
+    files (the "Software"), to deal in the Software without
+    restriction, including without limitation the rights to use, copy,
+    modify, merge, publish, distribute, sublicense, and/or sell copies
+    of the Software, and to permit persons to whom the Software is
+    furnished to do so, subject to the following conditions:
+
+    The above copyright notice and this permission notice shall be
+    included in all copies or substantial portions of the Software.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+    EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+    MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+    NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+    HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+    WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+    OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+    DEALINGS IN THE SOFTWARE.
+
+    $Id$
+
+    Append-only columnar log of the telemetry control frames.
+
+    The file is a 4 KB header followed by fixed size blocks.  Each block
+    holds up to TLOG_BLOCK_RECORDS records stored as one array per column
+    so a single channel of a block is a contiguous run of memory.  Blocks
+    are a whole number of pages and sit at computable offsets, so a reader
+    maps the file and binary searches the block headers by tick to find a
+    time without touching the rest of the file.  The block header record
+    count is written after the columns so a reader never sees a record
+    that has not been fully stored.
+*/
+
+#ifndef _RB2_TELEMETRY_TLOG_H_
+#define _RB2_TELEMETRY_TLOG_H_ 1
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TLOG_MAGIC              0x474c5442      // "BTLG"
+#define TLOG_BLOCK_MAGIC        0x4b4c4254      // "TBLK"
+#define TLOG_VERSION            1
+#define TLOG_HEADER_SIZE        4096
+#define TLOG_BLOCK_RECORDS      4096
+
+// Logged channels.  Each is stored as a column of int16 values.
+#define TLOG_PITCH_ANGLE        0
+#define TLOG_PITCH_RATE         1
+#define TLOG_TILT               2
+#define TLOG_LEFT_DELTA         3
+#define TLOG_RIGHT_DELTA        4
+#define TLOG_LEFT_PWM           5
+#define TLOG_RIGHT_PWM          6
+#define TLOG_CHANNELS           7
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t channels;          // Columns in each block.
+    uint32_t block_records;     // Records in a full block.
+    uint32_t block_size;        // Bytes in each block.
+    uint32_t period_us;         // Control period in microseconds.
+    int64_t start_time_ns;      // Host wall clock time the log was created.
+} tlog_header;
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t count;             // Records stored in the block.
+    uint64_t first_tick;        // Tick of the first record.
+    uint64_t last_tick;         // Tick of the last record.
+    int64_t host_time_ns;       // Host wall clock time of the first record.
+    uint8_t reserved[32];
+} tlog_block_header;
+
+// Records in the block follow the header as a column of 32 bit tick
+// offsets from first_tick and then one int16 column per channel.
+#define TLOG_TICKS_OFFSET       (sizeof(tlog_block_header))
+#define TLOG_CHANNEL_OFFSET(c)  (TLOG_TICKS_OFFSET + TLOG_BLOCK_RECORDS * 4 + (c) * TLOG_BLOCK_RECORDS * 2)
+
+typedef struct
+{
+    int fd;
+    tlog_header header;
+    uint64_t block;             // Index of the block being filled.
+    uint8_t *buffer;            // Copy of the block being filled.
+    uint32_t unflushed;         // Records not yet written to the file.
+    uint64_t records;           // Records in the log.
+    uint64_t last_tick;         // Tick of the last record in the log.
+} tlog_writer;
+
+typedef struct
+{
+    int fd;
+    const uint8_t *map;
+    size_t size;
+    const tlog_header *header;
+    uint64_t blocks;            // Blocks holding at least one record.
+} tlog_reader;
+
+extern const char *const tlog_channel_names[TLOG_CHANNELS];
+
+int tlog_writer_open(tlog_writer *writer, const char *path, uint32_t period_us);
+int tlog_writer_append(tlog_writer *writer, uint64_t tick, const int16_t *values, int64_t host_time_ns);
+int tlog_writer_flush(tlog_writer *writer);
+void tlog_writer_close(tlog_writer *writer);
+
+int tlog_reader_open(tlog_reader *reader, const char *path);
+void tlog_reader_close(tlog_reader *reader);
+const tlog_block_header *tlog_block(const tlog_reader *reader, uint64_t block);
+const uint32_t *tlog_block_ticks(const tlog_reader *reader, uint64_t block);
+const int16_t *tlog_block_channel(const tlog_reader *reader, uint64_t block, int channel);
+int tlog_seek(const tlog_reader *reader, uint64_t tick, uint64_t *block, uint32_t *index);
+int tlog_channel_find(const char *name);
+
+#endif // _RB2_TELEMETRY_TLOG_H_